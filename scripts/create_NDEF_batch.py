@@ -0,0 +1,130 @@
+# SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+# SPDX-License-Identifier: MIT
+
+"""
+Creates an indexed pack of per-device WiFi connection handover NDEF messages.
+
+The manifest is a CSV file (with header line) or a JSON list of objects with the fields:
+  device_id        Unique device identifier (at most 32 bytes UTF-8), used for the lookup at flash time
+  mac              P2P device address (aa:bb:cc:dd:ee:ff)
+  ssid             SSID of the P2P group owner (at most 32 bytes UTF-8), must match its device_name
+                   (set with scripts/wifi_p2p_setup.sh <device_name> on the device)
+  public_key_hash  Optional, 20 byte OOB password public key hash as hex (default: the fixed hash of
+                   scripts/create_NDEF_message.py, matching a group owner set up with scripts/wifi_p2p_setup.sh)
+  channel          Optional, advertised AP channel (default: 6)
+  rf_band          Optional, 2.4GHz or 5.0GHz (default: 2.4GHz)
+
+Pack layout (all integers little endian, see source/utilities/nbt-image.h):
+  Header (32 bytes): magic "NBTP", version, index entry size, entry count, index offset, data offset, pack length
+  Index (48 bytes per entry, sorted by device ID): device ID (32 bytes, NUL padded), offset, length, CRC-32, reserved
+  Data: NDEF messages including the 2 byte NLEN, each aligned to 16 bytes
+"""
+
+import argparse
+import csv
+import hashlib
+import json
+import multiprocessing
+import os
+import struct
+import sys
+import zlib
+
+import ndef
+
+PACK_MAGIC = b'NBTP'
+PACK_VERSION = 1
+HEADER_FORMAT = '<4sHHIIII8x'
+ENTRY_FORMAT = '<32sIII4x'
+DEVICE_ID_SIZE = 32
+ALIGNMENT = 16
+# Same OOB password public key hash as scripts/create_NDEF_message.py
+DEFAULT_PUBLIC_KEY_HASH = hashlib.sha256(b'DUMMY').digest()[0:20]
+
+
+def read_manifest(path: str) -> list:
+    with open(path, 'r', newline='') as f:
+        if path.lower().endswith('.json'):
+            return json.load(f)
+        return list(csv.DictReader(f))
+
+
+def encode_device(device: dict) -> tuple:
+    """Encodes the connection handover message of a single device (runs in worker processes)."""
+    device_id = str(device['device_id']).encode('utf-8')
+    if not device_id or len(device_id) > DEVICE_ID_SIZE:
+        raise ValueError(f"Invalid device ID '{device['device_id']}'")
+    mac_address = bytes(int(x, base=16) for x in device['mac'].split(':'))
+    if len(mac_address) != 6:
+        raise ValueError(f"Invalid MAC address '{device['mac']}' of device '{device['device_id']}'")
+    ssid = str(device.get('ssid') or '').encode('utf-8')
+    if not ssid or len(ssid) > 32:
+        raise ValueError(f"Missing or invalid SSID of device '{device['device_id']}'")
+    pkhash = bytes.fromhex(device['public_key_hash']) if device.get('public_key_hash') else DEFAULT_PUBLIC_KEY_HASH
+    if len(pkhash) != 20:
+        raise ValueError(f"Invalid public key hash of device '{device['device_id']}'")
+
+    oobpwd = ndef.wifi.OutOfBandPassword(pkhash, 0x0007, b'')
+    wfaext = ndef.wifi.WifiAllianceVendorExtension(('version-2', b'\x20'))
+    carrier = ndef.WifiSimpleConfigRecord()
+    carrier.name = '0'
+    carrier.set_attribute('oob-password', oobpwd)
+    carrier.set_attribute('ssid', ssid)
+    carrier.set_attribute('rf-bands', device.get('rf_band') or '2.4GHz')
+    carrier.set_attribute('ap-channel', int(device.get('channel') or 6))
+    carrier.set_attribute('mac-address', mac_address)
+    carrier['vendor-extension'] = [wfaext.encode()]
+    hs = ndef.handover.HandoverSelectRecord('1.3')
+    hs.add_alternative_carrier('active', carrier.name)
+    octets = b''.join(ndef.message_encoder([hs, carrier]))
+    return device_id, struct.pack('>H', len(octets)) + octets
+
+
+def write_pack(path: str, messages: list) -> None:
+    messages.sort(key=lambda message: message[0].ljust(DEVICE_ID_SIZE, b'\0'))
+    for previous, current in zip(messages, messages[1:]):
+        if previous[0] == current[0]:
+            raise ValueError(f"Duplicate device ID '{current[0].decode()}'")
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+    index_offset = header_size
+    data_offset = index_offset + len(messages) * entry_size
+    data_offset = (data_offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1)
+
+    index = bytearray()
+    data = bytearray()
+    for device_id, message in messages:
+        index += struct.pack(ENTRY_FORMAT, device_id, data_offset + len(data), len(message), zlib.crc32(message))
+        data += message
+        data += bytes(-len(data) % ALIGNMENT)
+    length = data_offset + len(data)
+    header = struct.pack(HEADER_FORMAT, PACK_MAGIC, PACK_VERSION, entry_size, len(messages), index_offset, data_offset, length)
+
+    with open(path + '.tmp', 'wb') as f:
+        f.write(header)
+        f.write(index)
+        f.write(bytes(data_offset - index_offset - len(index)))
+        f.write(data)
+    os.replace(path + '.tmp', path)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Create indexed pack of per-device connection handover NDEF messages.")
+    parser.add_argument('manifest', help="CSV or JSON manifest with one entry per device.")
+    parser.add_argument('pack', help="Pack file to be written.")
+    parser.add_argument('-j', '--jobs', type=int, help="Number of encoder processes (default: all cores).")
+    args = parser.parse_args()
+    jobs = max(1, args.jobs if args.jobs is not None else (os.cpu_count() or 1))
+
+    devices = read_manifest(args.manifest)
+    chunksize = max(1, len(devices) // (jobs * 8))
+    with multiprocessing.Pool(jobs) as pool:
+        messages = list(pool.imap_unordered(encode_device, devices, chunksize))
+    write_pack(args.pack, messages)
+    print(f"Wrote {len(messages)} messages to {args.pack}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -5,6 +5,9 @@
 
 source $(dirname $0)/config_files.sh
 
+# P2P device name, also used as SSID of the group owner (must match the SSID in the NDEF message)
+device_name=${1:-DIRECT-RasPi1}
+
 if [[ $(apt -qq list nmap  2>/dev/null | grep "\[installed\]$" ) == "" ]]; then
     echo "Installing nmap"
     sudo apt-get update
@@ -19,7 +22,7 @@ sudo bash -c "cat > $wpa_supplicant_file <<EOF
 ctrl_interface=DIR=/var/run/wpa_supplicant GROUP=netdev
 update_config=1
 country=DE
-device_name=DIRECT-RasPi1
+device_name=$device_name
 
 # If you need to modify the group owner intent, 0-15, the higher
 # number indicates preference to become the GO. You can also set
@@ -29,6 +32,11 @@ p2p_go_intent=15
 # In order to support 802.11n for the p2p Group Owner
 p2p_go_ht40=1
 
+# Operating channel of the p2p Group Owner (matches the advertised
+# connection handover message, updated by nbt-rpi -c)
+p2p_oper_reg_class=81
+p2p_oper_channel=6
+
 # Device type
 #   1-0050F204-1 (Computer / PC)
 #   1-0050F204-2 (Computer / Server)
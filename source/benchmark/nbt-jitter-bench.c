@@ -0,0 +1,416 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-jitter-bench.c
+ * \brief Latency distribution of the NBT I/O thread with and without real-time mode under synthetic CPU load.
+ *
+ * \details Runs the same measurement twice, first with a default I/O thread and then with nbt_realtime_thread_hook()
+ * (memory stays locked after the second run, so the order is fixed). Every run starts busy threads on all cores and
+ * executes samples as scheduler jobs:
+ *
+ *   * tag mode (default): latency of a 2-byte READ BINARY of the capability container
+ *   * synthetic mode (\c -s, no hardware required): wake-up latency of an absolute \c clock_nanosleep() on the I/O thread
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "infineon/i2c-rpi.h"
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-protocol.h"
+#include "infineon/ifx-t1prime.h"
+#include "infineon/logger-printf.h"
+#include "infineon/nbt-cmd.h"
+
+#include "../utilities/nbt-bus-lock.h"
+#include "../utilities/nbt-realtime.h"
+#include "../utilities/nbt-scheduler.h"
+#include "../utilities/nbt-utilities.h"
+
+#define RPI_I2C_FILE "/dev/i2c-1"
+#define LOG_TAG "NBT jitter bench"
+
+#define RPI_I2C_OPEN_FAIL (-1)
+
+/* Default number of samples per run */
+#define DEFAULT_ITERATIONS 2000U
+
+/* Default pause between two samples in microseconds */
+#define DEFAULT_INTERVAL_US 1000U
+
+/* Size of memory each load thread streams through (evicts caches of measured thread) */
+#define LOAD_BUFFER_SIZE (1024U * 1024U)
+
+/* Largest accepted number of samples, load threads and pause between samples in microseconds */
+#define MAX_ITERATIONS 10000000L
+#define MAX_LOAD_THREADS 1024L
+#define MAX_INTERVAL_US 1000000L
+
+/* IFX error encoding function identifier for errors of the benchmark itself (reported with LIB_NBT_REALTIME, outside
+   the range used by nbt-realtime.c) */
+#define JITTER_BENCH_MAIN 0x7FU
+
+/**
+ * \brief State of a single measurement run.
+ */
+struct bench_run
+{
+    /* true for synthetic wake-up latency, false for READ BINARY latency */
+    bool synthetic;
+
+    /* Pause between two samples in microseconds */
+    uint32_t interval_us;
+
+    /* Measured latencies in nanoseconds */
+    uint64_t *latencies;
+
+    /* Number of valid entries in latencies */
+    size_t count;
+
+    /* Number of failed samples */
+    size_t failures;
+};
+
+/* Set to stop load threads */
+static volatile bool load_stop;
+
+ifx_protocol_t gp_i2c_protocol;
+ifx_protocol_t bus_lock_protocol;
+ifx_protocol_t driver_adapter;
+static nbt_cmd_t nbt;
+
+/* Protocol stack and NBT abstraction to be destroyed on exit */
+static bool protocol_initialized;
+static bool nbt_initialized;
+
+/**
+ * \brief Returns monotonic time in nanoseconds.
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000U) + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * \brief Synthetic CPU and memory load until load_stop is set.
+ */
+static void *load_thread(void *arg)
+{
+    (void) arg;
+    uint8_t *buffer = (uint8_t *) malloc(LOAD_BUFFER_SIZE);
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+    uint32_t value = 1U;
+    while (!__atomic_load_n(&load_stop, __ATOMIC_RELAXED))
+    {
+        for (size_t i = 0U; i < LOAD_BUFFER_SIZE; i += 64U)
+        {
+            value = (value * 1103515245U) + 12345U;
+            buffer[i] = (uint8_t) value;
+        }
+    }
+    free(buffer);
+    return NULL;
+}
+
+/**
+ * \brief Scheduler job taking a single sample.
+ */
+static ifx_status_t sample_job(nbt_cmd_t *nbt, void *context)
+{
+    struct bench_run *run = (struct bench_run *) context;
+    uint64_t latency;
+    if (run->synthetic)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += (long) run->interval_us * 1000L;
+        while (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        uint64_t expected = ((uint64_t) deadline.tv_sec * 1000000000U) + (uint64_t) deadline.tv_nsec;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+        {
+        }
+        latency = now_ns() - expected;
+    }
+    else
+    {
+        uint8_t cclen[2];
+        uint64_t start = now_ns();
+        ifx_status_t status = nbt_read_file(nbt, NBT_FILEID_CC, 0U, sizeof(cclen), cclen);
+        latency = now_ns() - start;
+        if (ifx_error_check(status))
+        {
+            run->failures++;
+            return status;
+        }
+    }
+    run->latencies[run->count++] = latency;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Comparison function for qsort() of latencies.
+ */
+static int compare_latency(const void *a, const void *b)
+{
+    uint64_t left = *(const uint64_t *) a;
+    uint64_t right = *(const uint64_t *) b;
+    return (left > right) - (left < right);
+}
+
+/**
+ * \brief Returns nearest-rank percentile (in per mille) of sorted latencies in microseconds.
+ */
+static double percentile_us(const uint64_t *sorted, size_t count, size_t per_mille)
+{
+    size_t rank = ((count * per_mille) + 999U) / 1000U;
+    return (double) sorted[(rank == 0U) ? 0U : (rank - 1U)] / 1000.0;
+}
+
+/**
+ * \brief Executes one measurement run and prints its latency distribution.
+ */
+static ifx_status_t run_benchmark(const char *name, struct bench_run *run, size_t iterations, size_t load_threads,
+                                  struct nbt_realtime_config *realtime_config)
+{
+    struct nbt_scheduler scheduler = {0};
+    if (realtime_config != NULL)
+    {
+        scheduler.thread_hook = nbt_realtime_thread_hook;
+        scheduler.thread_hook_context = realtime_config;
+    }
+    ifx_status_t status = nbt_scheduler_start(&scheduler, &nbt);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+
+    pthread_t *loads = (pthread_t *) calloc(load_threads, sizeof(pthread_t));
+    __atomic_store_n(&load_stop, false, __ATOMIC_RELAXED);
+    size_t started = 0U;
+    while ((loads != NULL) && (started < load_threads) && (pthread_create(&loads[started], NULL, load_thread, NULL) == 0))
+    {
+        started++;
+    }
+
+    run->count = 0U;
+    run->failures = 0U;
+    for (size_t i = 0U; i < iterations; i++)
+    {
+        nbt_scheduler_execute(&scheduler, NBT_PRIORITY_PROBE, sample_job, run);
+        if (!run->synthetic)
+        {
+            usleep(run->interval_us);
+        }
+    }
+
+    __atomic_store_n(&load_stop, true, __ATOMIC_RELAXED);
+    for (size_t i = 0U; i < started; i++)
+    {
+        pthread_join(loads[i], NULL);
+    }
+    free(loads);
+    nbt_scheduler_stop(&scheduler);
+
+    if (run->count == 0U)
+    {
+        printf("%-8s no samples (%zu failures)\n", name, run->failures);
+        return IFX_SUCCESS;
+    }
+    qsort(run->latencies, run->count, sizeof(uint64_t), compare_latency);
+    printf("%-8s %8zu %8zu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, run->count, run->failures,
+           (double) run->latencies[0] / 1000.0, percentile_us(run->latencies, run->count, 500U),
+           percentile_us(run->latencies, run->count, 900U), percentile_us(run->latencies, run->count, 990U),
+           percentile_us(run->latencies, run->count, 999U), (double) run->latencies[run->count - 1U] / 1000.0);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Parses decimal command line argument within a range.
+ *
+ * \return bool \c true if \c text is a decimal number within range, \c false otherwise.
+ */
+static bool parse_number(const char *text, long minimum, long maximum, long *value)
+{
+    char *end = NULL;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if ((end == text) || (*end != '\0') || (errno != 0) || (parsed < minimum) || (parsed > maximum))
+    {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+/**
+ * \brief Opens protocol stack to NBT and selects NBT application.
+ */
+static ifx_status_t open_nbt(int *i2c_fd)
+{
+    if ((*i2c_fd = open(RPI_I2C_FILE, O_RDWR)) == -1)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Failed to open I2C character device");
+        return RPI_I2C_OPEN_FAIL;
+    }
+    ifx_status_t status = i2c_rpi_initialize(&driver_adapter, *i2c_fd, NBT_DEFAULT_I2C_ADDRESS);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    status = ifx_t1prime_initialize(&gp_i2c_protocol, &driver_adapter);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    status = nbt_bus_lock_initialize(&bus_lock_protocol, &gp_i2c_protocol, RPI_I2C_FILE, NBT_BUS_LOCK_DEFAULT_TIMEOUT_MS);
+    if (ifx_error_check(status))
+    {
+        ifx_protocol_destroy(&gp_i2c_protocol);
+        return status;
+    }
+    protocol_initialized = true;
+    status = ifx_protocol_activate(&bus_lock_protocol, NULL, NULL);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    status = nbt_initialize(&nbt, &bus_lock_protocol, ifx_logger_default);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    nbt_initialized = true;
+    return nbt_select_nbt_application(&nbt);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t iterations = DEFAULT_ITERATIONS;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t load_threads = (cores > 0) ? (size_t) cores : 1U;
+    struct bench_run run = {.synthetic = false, .interval_us = DEFAULT_INTERVAL_US};
+    struct nbt_realtime_config realtime_config = {.priority = NBT_REALTIME_DEFAULT_PRIORITY, .cpu = (cores > 1) ? (int) (cores - 1) : NBT_REALTIME_NO_CPU};
+    long max_cpu = (cores > 0) ? (cores - 1) : 0L;
+    long number = 0;
+    int option;
+    while ((option = getopt(argc, argv, "n:l:c:p:i:s")) != -1)
+    {
+        switch (option)
+        {
+        case 'n':
+            if (!parse_number(optarg, 1L, MAX_ITERATIONS, &number))
+            {
+                fprintf(stderr, "Invalid number of iterations %s (expected 1 to %ld)\n", optarg, MAX_ITERATIONS);
+                return EXIT_FAILURE;
+            }
+            iterations = (size_t) number;
+            break;
+        case 'l':
+            if (!parse_number(optarg, 0L, MAX_LOAD_THREADS, &number))
+            {
+                fprintf(stderr, "Invalid number of load threads %s (expected 0 to %ld)\n", optarg, MAX_LOAD_THREADS);
+                return EXIT_FAILURE;
+            }
+            load_threads = (size_t) number;
+            break;
+        case 'c':
+            if (!parse_number(optarg, NBT_REALTIME_NO_CPU, max_cpu, &number))
+            {
+                fprintf(stderr, "Invalid CPU %s (expected %d for no pinning or 0 to %ld)\n", optarg, NBT_REALTIME_NO_CPU, max_cpu);
+                return EXIT_FAILURE;
+            }
+            realtime_config.cpu = (int) number;
+            break;
+        case 'p':
+            if (!parse_number(optarg, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO), &number))
+            {
+                fprintf(stderr, "Invalid real-time priority %s (expected %d to %d)\n", optarg, sched_get_priority_min(SCHED_FIFO),
+                        sched_get_priority_max(SCHED_FIFO));
+                return EXIT_FAILURE;
+            }
+            realtime_config.priority = (int) number;
+            break;
+        case 'i':
+            if (!parse_number(optarg, 0L, MAX_INTERVAL_US, &number))
+            {
+                fprintf(stderr, "Invalid interval %s (expected 0 to %ld us)\n", optarg, MAX_INTERVAL_US);
+                return EXIT_FAILURE;
+            }
+            run.interval_us = (uint32_t) number;
+            break;
+        case 's':
+            run.synthetic = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n iterations] [-l load_threads] [-c cpu] [-p rt_priority] [-i interval_us] [-s]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    ifx_status_t status = logger_printf_initialize(ifx_logger_default);
+    if (ifx_error_check(status))
+    {
+        return EXIT_FAILURE;
+    }
+    ifx_logger_set_level(ifx_logger_default, IFX_LOG_WARN);
+
+    int i2c_fd = -1;
+    if (!run.synthetic)
+    {
+        status = open_nbt(&i2c_fd);
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not open NBT (use -s for synthetic mode)");
+            goto cleanup;
+        }
+    }
+    run.latencies = (uint64_t *) calloc(iterations, sizeof(uint64_t));
+    if (run.latencies == NULL)
+    {
+        status = IFX_ERROR(LIB_NBT_REALTIME, JITTER_BENCH_MAIN, IFX_OUT_OF_MEMORY);
+        goto cleanup;
+    }
+
+    printf("%s latency in us, %zu load threads, real-time CPU %d, priority %d\n", run.synthetic ? "Wake-up" : "READ BINARY", load_threads,
+           realtime_config.cpu, realtime_config.priority);
+    printf("%-8s %8s %8s %10s %10s %10s %10s %10s %10s\n", "mode", "samples", "failed", "min", "p50", "p90", "p99", "p99.9", "max");
+    status = run_benchmark("default", &run, iterations, load_threads, NULL);
+    if (!ifx_error_check(status))
+    {
+        status = run_benchmark("realtime", &run, iterations, load_threads, &realtime_config);
+    }
+    free(run.latencies);
+
+cleanup:
+    if (protocol_initialized)
+    {
+        ifx_protocol_destroy(&bus_lock_protocol);
+    }
+    if (nbt_initialized)
+    {
+        nbt_destroy(&nbt);
+    }
+    if (i2c_fd != -1)
+    {
+        close(i2c_fd);
+    }
+    return ifx_error_check(status) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
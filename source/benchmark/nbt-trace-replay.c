@@ -0,0 +1,730 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-trace-replay.c
+ * \brief Offline analysis and replay of an NBT trace recorded with \c nbt-rpi \c -T.
+ *
+ * \details Prints the latency distribution recorded in the field per command class and the host time between
+ * exchanges, then replays the APDU exchanges through nbt-utilities.c against a scripted transport:
+ *
+ *   * SELECT of the NBT application is issued with nbt_select_nbt_application().
+ *   * SELECT FILE followed by READ BINARY / UPDATE BINARY chunks is issued with nbt_read_file() / nbt_write_file().
+ *   * Everything else is sent as recorded.
+ *
+ * The scripted transport checks that every command matches the recorded one, answers with the recorded response and
+ * busy waits for the recorded exchange time (scaled with \c -x, 0 replays as fast as possible). Redundant re-selections
+ * of the current file (nbt_read_file() selects the file on every call) are answered without consuming the script.
+ * Any deviation aborts the replay with a non-zero exit code, so traces can be used as regression benchmarks.
+ */
+#include <endian.h>
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-protocol.h"
+#include "infineon/logger-printf.h"
+#include "infineon/nbt-cmd.h"
+
+#include "../utilities/nbt-trace.h"
+#include "../utilities/nbt-utilities.h"
+
+#define LOG_TAG "NBT trace replay"
+
+/* Default number of replay iterations */
+#define DEFAULT_ITERATIONS 1U
+
+/* Maximum number of replay iterations */
+#define MAX_ITERATIONS 1000000L
+
+/* Maximum time scale (exchange times are stretched at most by this factor) */
+#define MAX_TIME_SCALE 1000.0
+
+/* IFX error encoding function identifier of the scripted transport */
+#define REPLAY_TRANSPORT 0x10U
+
+/* Error reason if a command deviates from the trace */
+#define REPLAY_MISMATCH 0x21U
+
+/* Error reason if the traced exchange failed */
+#define REPLAY_RECORDED_FAILURE 0x22U
+
+/* APDU instruction bytes */
+#define INS_SELECT 0xA4U
+#define INS_READ_BINARY 0xB0U
+#define INS_UPDATE_BINARY 0xD6U
+
+/* Maximum number of bytes printed per record with -p */
+#define PRINT_MAX_BYTES 24U
+
+/**
+ * \brief AID of the NBT (NDEF) application.
+ */
+static const uint8_t NBT_APPLICATION_AID[] = {0xD2U, 0x76U, 0x00U, 0x00U, 0x85U, 0x01U, 0x01U};
+
+/**
+ * \brief Recorded activation or APDU exchange.
+ */
+struct replay_exchange
+{
+    /* true for activation, false for APDU exchange */
+    bool activate;
+
+    /* true if the exchange failed in the field */
+    bool failed;
+
+    /* Command APDU within the mapped trace */
+    const uint8_t *command;
+    size_t command_length;
+
+    /* Response (APDU including status word or activation response) within the mapped trace */
+    const uint8_t *response;
+    size_t response_length;
+
+    /* Recorded start and duration of the exchange in nanoseconds */
+    uint64_t timestamp_ns;
+    uint64_t duration_ns;
+};
+
+/**
+ * \brief State of the scripted transport.
+ */
+struct replay_transport
+{
+    /* Recorded exchanges */
+    struct replay_exchange *script;
+    size_t count;
+
+    /* Index of next expected exchange */
+    size_t cursor;
+
+    /* Factor applied to recorded exchange times */
+    double scale;
+
+    /* Currently selected file (0 if none) */
+    uint16_t selected_file;
+
+    /* Time spent emulating the tag in nanoseconds */
+    uint64_t injected_ns;
+
+    /* Number of redundant file selections answered without consuming the script */
+    size_t synthetic;
+
+    /* Set if a command deviated from the trace */
+    bool mismatch;
+};
+
+/**
+ * \brief Recorded latencies of one command class.
+ */
+struct latency_class
+{
+    const char *name;
+    uint64_t *latencies;
+    size_t count;
+};
+
+static struct replay_transport state;
+static ifx_protocol_t transport;
+static nbt_cmd_t nbt;
+
+/**
+ * \brief Returns monotonic time in nanoseconds.
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000U) + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * \brief Busy waits for the scaled duration of a recorded exchange (sleeping would add scheduler latency).
+ */
+static void emulate_exchange_time(const struct replay_exchange *exchange)
+{
+    uint64_t duration = (uint64_t) ((double) exchange->duration_ns * state.scale);
+    uint64_t deadline = now_ns() + duration;
+    while (now_ns() < deadline)
+    {
+    }
+    state.injected_ns += duration;
+}
+
+/**
+ * \brief Returns true if exchange is a command APDU with the given instruction byte.
+ */
+static bool is_instruction(const struct replay_exchange *exchange, uint8_t ins)
+{
+    return !exchange->activate && (exchange->command_length >= 4U) && (exchange->command[1] == ins);
+}
+
+/**
+ * \brief Returns true if command selects a file by its 2-byte file ID and stores the ID.
+ */
+static bool is_select_file(const uint8_t *command, size_t length, uint16_t *file_id)
+{
+    if ((length < 7U) || (command[1] != INS_SELECT) || (command[2] != 0x00U) || (command[4] != 0x02U))
+    {
+        return false;
+    }
+    *file_id = (uint16_t) ((command[5] << 8) | command[6]);
+    return true;
+}
+
+/**
+ * \brief Returns true if command selects an application by its AID.
+ */
+static bool is_select_application(const uint8_t *command, size_t length, const uint8_t *aid, size_t aid_length)
+{
+    return (length >= (5U + aid_length)) && (command[1] == INS_SELECT) && (command[2] == 0x04U) && (command[4] == aid_length) &&
+           (memcmp(command + 5U, aid, aid_length) == 0);
+}
+
+/**
+ * \brief Prints up to PRINT_MAX_BYTES of data as hex.
+ */
+static void print_hex(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0U; (i < length) && (i < PRINT_MAX_BYTES); i++)
+    {
+        printf("%02X", data[i]);
+    }
+    printf("%s", (length > PRINT_MAX_BYTES) ? "..." : "");
+}
+
+/**
+ * \brief Copies recorded response into a buffer owned by the caller of the transport.
+ */
+static ifx_status_t respond(const struct replay_exchange *exchange, uint8_t **response, size_t *response_len)
+{
+    if (exchange->failed)
+    {
+        return IFX_ERROR(LIB_NBT_TRACE, REPLAY_TRANSPORT, REPLAY_RECORDED_FAILURE);
+    }
+    if ((response == NULL) || (response_len == NULL))
+    {
+        return IFX_SUCCESS;
+    }
+    *response = (uint8_t *) malloc((exchange->response_length > 0U) ? exchange->response_length : 1U);
+    if (*response == NULL)
+    {
+        return IFX_ERROR(LIB_NBT_TRACE, REPLAY_TRANSPORT, IFX_OUT_OF_MEMORY);
+    }
+    memcpy(*response, exchange->response, exchange->response_length);
+    *response_len = exchange->response_length;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Scripted activation answering with the recorded activation response.
+ */
+static ifx_status_t transport_activate(ifx_protocol_t *self, uint8_t **response, size_t *response_len)
+{
+    (void) self;
+    if ((state.cursor >= state.count) || !state.script[state.cursor].activate)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Unexpected activation at exchange %zu", state.cursor);
+        state.mismatch = true;
+        return IFX_ERROR(LIB_NBT_TRACE, REPLAY_TRANSPORT, REPLAY_MISMATCH);
+    }
+    const struct replay_exchange *exchange = &state.script[state.cursor++];
+    emulate_exchange_time(exchange);
+    state.selected_file = 0U;
+    return respond(exchange, response, response_len);
+}
+
+/**
+ * \brief Scripted APDU exchange checking the command against the trace and answering with the recorded response.
+ */
+static ifx_status_t transport_transceive(ifx_protocol_t *self, const uint8_t *data, size_t data_len, uint8_t **response, size_t *response_len)
+{
+    (void) self;
+    const struct replay_exchange *exchange = (state.cursor < state.count) ? &state.script[state.cursor] : NULL;
+    uint16_t file_id = 0U;
+    if ((exchange != NULL) && !exchange->activate && (exchange->command_length == data_len) && (memcmp(exchange->command, data, data_len) == 0))
+    {
+        state.cursor++;
+        emulate_exchange_time(exchange);
+        size_t length = exchange->response_length;
+        bool ok = !exchange->failed && (length >= 2U) && (exchange->response[length - 2U] == 0x90U) && (exchange->response[length - 1U] == 0x00U);
+        if ((data_len >= 2U) && (data[1] == INS_SELECT))
+        {
+            state.selected_file = (ok && is_select_file(data, data_len, &file_id)) ? file_id : 0U;
+        }
+        return respond(exchange, response, response_len);
+    }
+    if (is_select_file(data, data_len, &file_id) && (file_id == state.selected_file) && (file_id != 0U))
+    {
+        state.synthetic++;
+        static const uint8_t SW_OK[] = {0x90U, 0x00U};
+        struct replay_exchange selected = {.response = SW_OK, .response_length = sizeof(SW_OK)};
+        return respond(&selected, response, response_len);
+    }
+
+    state.mismatch = true;
+    printf("Mismatch at exchange %zu\n  sent:     ", state.cursor);
+    print_hex(data, data_len);
+    printf("\n  recorded: ");
+    if ((exchange == NULL) || exchange->activate)
+    {
+        printf("%s", (exchange == NULL) ? "end of trace" : "activation");
+    }
+    else
+    {
+        print_hex(exchange->command, exchange->command_length);
+    }
+    printf("\n");
+    return IFX_ERROR(LIB_NBT_TRACE, REPLAY_TRANSPORT, REPLAY_MISMATCH);
+}
+
+/**
+ * \brief Collects consecutive READ BINARY or UPDATE BINARY chunks that a single nbt_read_file() / nbt_write_file()
+ * call issues.
+ *
+ * \return size_t Number of exchanges in the run (0 if the exchange at \c index cannot start a run).
+ */
+static size_t collect_run(size_t index, uint8_t ins, uint16_t *offset, uint8_t *data, size_t *length)
+{
+    size_t end = index;
+    *length = 0U;
+    while ((end < state.count) && is_instruction(&state.script[end], ins) && (state.script[end].command_length >= 5U))
+    {
+        const uint8_t *command = state.script[end].command;
+        uint16_t chunk_offset = (uint16_t) ((command[2] << 8) | command[3]);
+        size_t chunk_length = command[4];
+        if (end == index)
+        {
+            *offset = chunk_offset;
+        }
+        if ((chunk_length == 0U) || (chunk_offset != (*offset + *length)) || ((*offset + *length + chunk_length) > 4096U) ||
+            ((ins == INS_UPDATE_BINARY) && (state.script[end].command_length != (5U + chunk_length))))
+        {
+            break;
+        }
+        if (ins == INS_UPDATE_BINARY)
+        {
+            memcpy(data + *length, command + 5U, chunk_length);
+        }
+        *length += chunk_length;
+        end++;
+        if (chunk_length != 0xFFU)
+        {
+            break;
+        }
+    }
+    return end - index;
+}
+
+/**
+ * \brief Replays the complete script once through nbt-utilities.c.
+ *
+ * \return ifx_status_t \c IFX_SUCCESS if all commands matched the trace, any other value in case of error.
+ */
+static ifx_status_t replay_once(void)
+{
+    state.cursor = 0U;
+    state.selected_file = 0U;
+    state.injected_ns = 0U;
+    state.synthetic = 0U;
+    state.mismatch = false;
+
+    uint8_t buffer[4096];
+    size_t index = 0U;
+    while ((index < state.count) && !state.mismatch)
+    {
+        const struct replay_exchange *exchange = &state.script[index];
+        uint16_t file_id = 0U;
+        uint16_t offset = 0U;
+        size_t length = 0U;
+        uint8_t *response = NULL;
+        size_t response_len = 0U;
+        ifx_status_t status;
+        if (exchange->activate)
+        {
+            status = ifx_protocol_activate(&transport, &response, &response_len);
+        }
+        else if (is_select_application(exchange->command, exchange->command_length, NBT_APPLICATION_AID, sizeof(NBT_APPLICATION_AID)))
+        {
+            status = nbt_select_nbt_application(&nbt);
+        }
+        else if ((is_select_file(exchange->command, exchange->command_length, &file_id) && ((index + 1U) < state.count) &&
+                  (collect_run(index + 1U, INS_READ_BINARY, &offset, buffer, &length) > 0U)) ||
+                 ((state.selected_file != 0U) && (collect_run(index, INS_READ_BINARY, &offset, buffer, &length) > 0U)))
+        {
+            status = nbt_read_file(&nbt, (file_id != 0U) ? file_id : state.selected_file, offset, length, buffer);
+        }
+        else if ((is_select_file(exchange->command, exchange->command_length, &file_id) && ((index + 1U) < state.count) &&
+                  (collect_run(index + 1U, INS_UPDATE_BINARY, &offset, buffer, &length) > 0U)) ||
+                 ((state.selected_file != 0U) && (collect_run(index, INS_UPDATE_BINARY, &offset, buffer, &length) > 0U)))
+        {
+            status = nbt_write_file(&nbt, (file_id != 0U) ? file_id : state.selected_file, offset, buffer, length);
+        }
+        else
+        {
+            status = ifx_protocol_transceive(&transport, exchange->command, exchange->command_length, &response, &response_len);
+        }
+        if (!ifx_error_check(status))
+        {
+            free(response);
+        }
+
+        // Failures recorded in the field are reproduced, only deviations from the trace abort the replay
+        index = (state.cursor > index) ? state.cursor : (index + 1U);
+    }
+    return state.mismatch ? IFX_ERROR(LIB_NBT_TRACE, REPLAY_TRANSPORT, REPLAY_MISMATCH) : IFX_SUCCESS;
+}
+
+/**
+ * \brief Comparison function for qsort() of latencies.
+ */
+static int compare_latency(const void *a, const void *b)
+{
+    uint64_t left = *(const uint64_t *) a;
+    uint64_t right = *(const uint64_t *) b;
+    return (left > right) - (left < right);
+}
+
+/**
+ * \brief Returns nearest-rank percentile (in per mille) of sorted latencies in microseconds.
+ */
+static double percentile_us(const uint64_t *sorted, size_t count, size_t per_mille)
+{
+    size_t rank = ((count * per_mille) + 999U) / 1000U;
+    return (double) sorted[(rank == 0U) ? 0U : (rank - 1U)] / 1000.0;
+}
+
+/**
+ * \brief Prints latency distribution of one class.
+ */
+static void print_latencies(struct latency_class *latency)
+{
+    if (latency->count == 0U)
+    {
+        return;
+    }
+    qsort(latency->latencies, latency->count, sizeof(uint64_t), compare_latency);
+    printf("%-14s %8zu %10.1f %10.1f %10.1f %10.1f\n", latency->name, latency->count, (double) latency->latencies[0] / 1000.0,
+           percentile_us(latency->latencies, latency->count, 500U), percentile_us(latency->latencies, latency->count, 990U),
+           (double) latency->latencies[latency->count - 1U] / 1000.0);
+}
+
+/**
+ * \brief Returns index of the latency class of a command (SELECT, READ BINARY, UPDATE BINARY, other).
+ */
+static size_t latency_class_of(const uint8_t *command, size_t length)
+{
+    if (length < 2U)
+    {
+        return 3U;
+    }
+    switch (command[1])
+    {
+    case INS_SELECT:
+        return 0U;
+    case INS_READ_BINARY:
+        return 1U;
+    case INS_UPDATE_BINARY:
+        return 2U;
+    default:
+        return 3U;
+    }
+}
+
+/**
+ * \brief Returns printable name of a record type.
+ */
+static const char *record_name(uint8_t type)
+{
+    switch (type)
+    {
+    case NBT_TRACE_RECORD_SESSION:
+        return "session";
+    case NBT_TRACE_RECORD_FRAME_TX:
+        return "frame>";
+    case NBT_TRACE_RECORD_FRAME_RX:
+        return "frame<";
+    case NBT_TRACE_RECORD_ACTIVATE:
+        return "activate";
+    case NBT_TRACE_RECORD_APDU:
+        return "apdu>";
+    case NBT_TRACE_RECORD_RESPONSE:
+        return "apdu<";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * \brief Reads all records of the trace into the script and prints the recorded timings.
+ *
+ * \details The script starts at the first activation in the ring, so that replay does not begin in the middle of a
+ * file operation whose start has already been overwritten.
+ */
+static ifx_status_t analyse_trace(const struct nbt_trace *trace, bool print)
+{
+    // Every record occupies at least its header, which bounds the number of exchanges in the ring
+    size_t capacity = trace->capacity / sizeof(struct nbt_trace_record);
+    struct latency_class classes[] = {{.name = "SELECT"}, {.name = "READ BINARY"}, {.name = "UPDATE BINARY"}, {.name = "other"}, {.name = "host gap"}};
+    const size_t class_count = sizeof(classes) / sizeof(classes[0]);
+    bool allocated = true;
+    for (size_t i = 0U; i < class_count; i++)
+    {
+        classes[i].latencies = (uint64_t *) calloc(capacity, sizeof(uint64_t));
+        allocated = allocated && (classes[i].latencies != NULL);
+    }
+    state.script = (struct replay_exchange *) calloc(capacity, sizeof(struct replay_exchange));
+    if (!allocated || (state.script == NULL))
+    {
+        for (size_t i = 0U; i < class_count; i++)
+        {
+            free(classes[i].latencies);
+        }
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_LOAD, IFX_OUT_OF_MEMORY);
+    }
+
+    size_t sessions = 0U;
+    size_t frames = 0U;
+    size_t frame_bytes = 0U;
+    size_t frame_errors = 0U;
+    size_t apdus = 0U;
+    bool started = false;
+    uint64_t first_timestamp = 0U;
+    uint64_t previous_end = 0U;
+    struct replay_exchange *pending = NULL;
+    uint64_t position = 0U;
+    struct nbt_trace_record record;
+    const uint8_t *payload;
+    while (nbt_trace_next(trace, &position, &record, &payload))
+    {
+        if (print)
+        {
+            if (first_timestamp == 0U)
+            {
+                first_timestamp = record.timestamp_ns;
+            }
+            printf("%12.3f ms %-8s %8.1f us %s ", (double) (record.timestamp_ns - first_timestamp) / 1000000.0, record_name(record.type),
+                   (double) record.duration_ns / 1000.0, (record.flags & NBT_TRACE_FLAG_ERROR) ? "ERR" : "   ");
+            print_hex(payload, record.length);
+            printf("\n");
+        }
+        switch (record.type)
+        {
+        case NBT_TRACE_RECORD_SESSION:
+            sessions++;
+            previous_end = 0U;
+            break;
+        case NBT_TRACE_RECORD_FRAME_TX:
+        case NBT_TRACE_RECORD_FRAME_RX:
+            frames++;
+            frame_bytes += record.length;
+            frame_errors += (record.flags & NBT_TRACE_FLAG_ERROR) ? 1U : 0U;
+            break;
+        case NBT_TRACE_RECORD_ACTIVATE:
+            started = true;
+            state.script[state.count++] = (struct replay_exchange){.activate = true,
+                                                                   .failed = (record.flags & NBT_TRACE_FLAG_ERROR) != 0U,
+                                                                   .response = payload,
+                                                                   .response_length = record.length,
+                                                                   .timestamp_ns = record.timestamp_ns,
+                                                                   .duration_ns = record.duration_ns};
+            previous_end = record.timestamp_ns + record.duration_ns;
+            break;
+        case NBT_TRACE_RECORD_APDU:
+            pending = NULL;
+            if (started)
+            {
+                pending = &state.script[state.count];
+                *pending = (struct replay_exchange){.command = payload, .command_length = record.length, .timestamp_ns = record.timestamp_ns};
+            }
+            break;
+        case NBT_TRACE_RECORD_RESPONSE:
+            if ((pending == NULL) || (pending->timestamp_ns != record.timestamp_ns))
+            {
+                break;
+            }
+            pending->failed = (record.flags & NBT_TRACE_FLAG_ERROR) != 0U;
+            pending->response = payload;
+            pending->response_length = record.length;
+            pending->duration_ns = record.duration_ns;
+            state.count++;
+            apdus++;
+            struct latency_class *latency = &classes[latency_class_of(pending->command, pending->command_length)];
+            latency->latencies[latency->count++] = record.duration_ns;
+            if ((previous_end != 0U) && (record.timestamp_ns >= previous_end))
+            {
+                classes[4].latencies[classes[4].count++] = record.timestamp_ns - previous_end;
+            }
+            previous_end = record.timestamp_ns + record.duration_ns;
+            pending = NULL;
+            break;
+        default:
+            break;
+        }
+    }
+
+    printf("Trace: %zu sessions, %llu records (%llu overwritten), %zu APDUs, %zu frames (%zu bytes, %zu failed)\n", sessions,
+           (unsigned long long) le64toh(trace->header->records), (unsigned long long) le64toh(trace->header->dropped), apdus, frames, frame_bytes,
+           frame_errors);
+    printf("%-14s %8s %10s %10s %10s %10s\n", "field us", "count", "min", "p50", "p99", "max");
+    for (size_t i = 0U; i < class_count; i++)
+    {
+        print_latencies(&classes[i]);
+        free(classes[i].latencies);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Parses decimal command line argument within a range.
+ *
+ * \param[in] text Argument to be parsed.
+ * \param[in] minimum Smallest accepted value.
+ * \param[in] maximum Largest accepted value.
+ * \param[out] value Parsed value (only written on success).
+ * \return bool \c true if \c text is a number within range.
+ */
+static bool parse_number(const char *text, long minimum, long maximum, long *value)
+{
+    char *end = NULL;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if ((end == text) || (*end != '\0') || (errno != 0) || (parsed < minimum) || (parsed > maximum))
+    {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+/**
+ * \brief Parses time scale argument (finite, 0 to \c MAX_TIME_SCALE).
+ *
+ * \param[in] text Argument to be parsed.
+ * \param[out] value Parsed value (only written on success).
+ * \return bool \c true if \c text is a valid time scale.
+ */
+static bool parse_scale(const char *text, double *value)
+{
+    char *end = NULL;
+    errno = 0;
+    double parsed = strtod(text, &end);
+    if ((end == text) || (*end != '\0') || (errno != 0) || !isfinite(parsed) || (parsed < 0.0) || (parsed > MAX_TIME_SCALE))
+    {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+/**
+ * \brief Prints command line usage.
+ */
+static void print_usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [-x time_scale] [-n iterations] [-p] trace_file\n", program);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t iterations = DEFAULT_ITERATIONS;
+    bool print = false;
+    long number = 0;
+    state.scale = 1.0;
+    int option;
+    while ((option = getopt(argc, argv, "x:n:p")) != -1)
+    {
+        switch (option)
+        {
+        case 'x':
+            if (!parse_scale(optarg, &state.scale))
+            {
+                fprintf(stderr, "Invalid time scale %s (expected 0 to %.0f)\n", optarg, MAX_TIME_SCALE);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'n':
+            if (!parse_number(optarg, 1L, MAX_ITERATIONS, &number))
+            {
+                fprintf(stderr, "Invalid number of iterations %s (expected 1 to %ld)\n", optarg, MAX_ITERATIONS);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            iterations = (size_t) number;
+            break;
+        case 'p':
+            print = true;
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind != (argc - 1))
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ifx_status_t status = logger_printf_initialize(ifx_logger_default);
+    if (ifx_error_check(status))
+    {
+        return EXIT_FAILURE;
+    }
+    ifx_logger_set_level(ifx_logger_default, IFX_LOG_WARN);
+
+    struct nbt_trace trace;
+    status = nbt_trace_load(&trace, argv[optind]);
+    if (ifx_error_check(status))
+    {
+        return EXIT_FAILURE;
+    }
+    status = analyse_trace(&trace, print);
+    if (ifx_error_check(status) || (state.count == 0U))
+    {
+        goto cleanup;
+    }
+
+    // Scripted transport as the only protocol layer below the NBT command abstraction
+    status = ifx_protocol_layer_initialize(&transport);
+    if (ifx_error_check(status))
+    {
+        goto cleanup;
+    }
+    transport._activate = transport_activate;
+    transport._transceive = transport_transceive;
+    status = nbt_initialize(&nbt, &transport, ifx_logger_default);
+    if (ifx_error_check(status))
+    {
+        goto cleanup;
+    }
+
+    printf("Replay of %zu exchanges, time scale %.2f\n", state.count, state.scale);
+    printf("%-9s %10s %12s %12s %12s\n", "iteration", "synthetic", "wall us", "tag us", "host us");
+    for (size_t i = 0U; i < iterations; i++)
+    {
+        uint64_t start = now_ns();
+        status = replay_once();
+        uint64_t wall = now_ns() - start;
+        if (ifx_error_check(status))
+        {
+            break;
+        }
+        printf("%-9zu %10zu %12.1f %12.1f %12.1f\n", i, state.synthetic, (double) wall / 1000.0, (double) state.injected_ns / 1000.0,
+               (double) (wall - state.injected_ns) / 1000.0);
+    }
+    nbt_destroy(&nbt);
+
+cleanup:
+    free(state.script);
+    nbt_trace_close(&trace);
+    return ifx_error_check(status) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
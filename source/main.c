@@ -10,9 +10,15 @@
 #include "infineon/logger-printf.h"
 
 #include "utilities/nbt-utilities.h"
-
-/* Required for POSIX threads */
-#include <pthread.h>
+#include "utilities/nbt-scheduler.h"
+#include "utilities/nbt-ringlog.h"
+#include "utilities/nbt-handover.h"
+#include "utilities/nbt-bus-lock.h"
+#include "utilities/nbt-health.h"
+#include "utilities/nbt-image.h"
+#include "utilities/nbt-channel-plan.h"
+#include "utilities/nbt-realtime.h"
+#include "utilities/nbt-trace.h"
 
 /* Required for I2C */
 #include <unistd.h>
@@ -20,17 +26,29 @@
 #include <sys/ioctl.h>
 #include <linux/i2c-dev.h>
 
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /* NBT slave address */
 #define NBT_DEFAULT_I2C_ADDRESS 0x18U
 #define RPI_I2C_FILE  "/dev/i2c-1"
 #define LOG_TAG "NBT example"
+#define DEFAULT_STATUS_FILE "/run/nbt-rpi.status"
+#define MAX_PROBE_INTERVAL_MS 86400000L
 
 #define RPI_I2C_OPEN_FAIL   (-1)
 #define RPI_I2C_INIT_FAIL   (-2)
 #define OPTIGA_NBT_ERROR    (-3)
 
+/* Telemetry ring log events */
+#define TELEMETRY_EVENT_STARTUP      0x01U
+#define TELEMETRY_EVENT_NDEF_WRITTEN 0x02U
+
 /**
  * \brief Skeleton for WiFi connection handover message.
  */
@@ -60,6 +78,9 @@ static uint8_t WIFI_CONNECTION_HANDOVER_MESSAGE[] =
 // Protocol to handle the GP T=1' I2C protocol communication with tag
 ifx_protocol_t gp_i2c_protocol;
 
+// Protocol arbitrating the shared I2C bus with other processes (per APDU)
+ifx_protocol_t bus_lock_protocol;
+
 // Protocol to handle communication with Raspberry PI I2C driver
 ifx_protocol_t driver_adapter;
 /* Initialize protocol driver layer here with I2C implementation.
@@ -69,13 +90,102 @@ Note: Does not work without initialized driver layer for I2C. */
 ifx_logger_t logger_implementation;
 
 /**
- * \brief NBT abstraction.
+ * \brief NBT abstraction (exclusively used by the scheduler's I/O thread).
  */
 static nbt_cmd_t nbt;
 
+/**
+ * \brief Scheduler owning the NBT abstraction.
+ */
+static struct nbt_scheduler scheduler;
+
+/**
+ * \brief NFC-readable telemetry ring log in proprietary file 1.
+ */
+static struct nbt_ringlog telemetry;
+
+/**
+ * \brief Field index and session credentials of WIFI_CONNECTION_HANDOVER_MESSAGE.
+ */
+static struct nbt_handover handover;
+
+/**
+ * \brief Periodic liveness probe used in monitor mode.
+ */
+static struct nbt_health health;
+
+/**
+ * \brief Optional binary trace of all frames and APDUs exchanged with the NBT.
+ */
+static struct nbt_trace trace;
+
+/**
+ * \brief Frame tap around driver_adapter (only used while tracing).
+ */
+static struct nbt_trace_tap trace_tap;
+
+/**
+ * \brief APDU trace protocol layer on top of gp_i2c_protocol (only used while tracing).
+ */
+static ifx_protocol_t trace_protocol;
+
+/**
+ * \brief Pregenerated per-device NDEF messages (mapped only if an image pack is given).
+ */
+static struct nbt_image_pack image_pack;
+
+/**
+ * \brief NDEF message to be provisioned by nbt_write_ndef().
+ */
+struct nbt_ndef_message
+{
+    /**
+     * \brief Complete NDEF file content (including NLEN).
+     */
+    const uint8_t *data;
+
+    /**
+     * \brief Number of bytes in nbt_ndef_message.data.
+     */
+    size_t length;
+};
+
 /* I2C file descriptor */
 static int i2c_fd;
 
+/**
+ * \brief Parses decimal command line argument within a range.
+ *
+ * \param[in] text Argument to be parsed.
+ * \param[in] minimum Smallest accepted value.
+ * \param[in] maximum Largest accepted value.
+ * \param[out] value Parsed value.
+ * \return bool \c true if \c text is a decimal number within range, \c false otherwise.
+ */
+static bool parse_number(const char *text, long minimum, long maximum, long *value)
+{
+    char *end = NULL;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if ((end == text) || (*end != '\0') || (errno != 0) || (parsed < minimum) || (parsed > maximum))
+    {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+/**
+ * \brief Scheduler job hook pausing the trace during health probes.
+ *
+ * \param[in] context Trace (\c struct nbt_trace *).
+ * \param[in] priority Priority of the job about to be executed.
+ */
+static void trace_exclude_probes(void *context, enum nbt_scheduler_priority priority)
+{
+    ((struct nbt_trace *) context)->paused = (priority == NBT_PRIORITY_PROBE);
+}
+
 
 /**
  * \brief Configures NBT for Wifi connection handover usecase.
@@ -105,9 +215,9 @@ static ifx_status_t nbt_configure_wifi_connection_handover(nbt_cmd_t *nbt)
                                               .nfc_read_access_condition = NBT_ACCESS_ALWAYS,
                                               .nfc_write_access_condition = NBT_ACCESS_ALWAYS};
     const nbt_file_access_policy_t fap_proprietary1 = {.file_id = NBT_FILEID_PROPRIETARY1,
-                                                       .i2c_read_access_condition = NBT_ACCESS_NEVER,
-                                                       .i2c_write_access_condition = NBT_ACCESS_NEVER,
-                                                       .nfc_read_access_condition = NBT_ACCESS_NEVER,
+                                                       .i2c_read_access_condition = NBT_ACCESS_ALWAYS,
+                                                       .i2c_write_access_condition = NBT_ACCESS_ALWAYS,
+                                                       .nfc_read_access_condition = NBT_ACCESS_ALWAYS,
                                                        .nfc_write_access_condition = NBT_ACCESS_NEVER};
     const nbt_file_access_policy_t fap_proprietary2 = {.file_id = NBT_FILEID_PROPRIETARY2,
                                                        .i2c_read_access_condition = NBT_ACCESS_NEVER,
@@ -135,84 +245,233 @@ static ifx_status_t nbt_configure_wifi_connection_handover(nbt_cmd_t *nbt)
         ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_FATAL, "Could not confgure NBT for connection handover usecase.");
         return status;
     }
+    return IFX_SUCCESS;
 }
 
 
 /**
- * \brief posix thread to write the Wifi P2P connection handover Select data to NDEF file
+ * \brief Scheduler job to write the Wifi P2P connection handover Select data to NDEF file
  *
  * \details
  *   * Opens communication channel to NBT.
- *   * Configures NBT for asynchronous data transfer usecase.
- *   * Reads configuration from NBT proprietary file 1.
- *   * Sets LED state depending on configuration.
- *   * Writes LED state to NBT proprietary file 2.
- *   * Waits for button interrupt and starts loop again.
+ *   * Configures NBT for WiFi connection handover usecase.
+ *   * Selects NBT application.
+ *   * Reads current NDEF file and writes only the parts of the connection handover message that differ (usually only
+ *     the planned channel and band).
  *
- * \see nbt_configure_adt()
+ * \param[in] nbt NBT abstraction owned by the scheduler's I/O thread.
+ * \param[in] context NDEF message to be written (\c const struct nbt_ndef_message *).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ * \see nbt_configure_wifi_connection_handover()
  */
-void* nbt_write_ndef(void *arg)
+static ifx_status_t nbt_write_ndef(nbt_cmd_t *nbt, void *context)
 {
+    const struct nbt_ndef_message *message = (const struct nbt_ndef_message *) context;
+
     // Activate communication channel to NBT
     uint8_t *atpo = NULL;
     size_t atpo_len = 0U;
-    ifx_status_t status = ifx_protocol_activate(&gp_i2c_protocol, &atpo, &atpo_len);
+    ifx_status_t status = ifx_protocol_activate(&bus_lock_protocol, &atpo, &atpo_len);
     if (ifx_error_check(status))
     {
         ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_FATAL, "Could not open communication channel to NBT");
-        goto exit;
+        return status;
     }
 
     // Set NBT to Connection handover configuration
-    status = nbt_configure_wifi_connection_handover(&nbt);
+    status = nbt_configure_wifi_connection_handover(nbt);
     if (ifx_error_check(status))
     {
         ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_FATAL, "Could not set NBT to WiFi Connection handover configuration");
-        goto exit;
+        return status;
     }
 
     // Use NBT command abstraction
-    status = nbt_select_nbt_application(&nbt);
+    status = nbt_select_nbt_application(nbt);
     if (ifx_error_check(status))
     {
         ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not select NBT application");
-        goto exit;
+        return status;
     }
 
-    // Write the NDEF message
-    status = nbt_write_file(&nbt, NBT_FILEID_NDEF, 0U, WIFI_CONNECTION_HANDOVER_MESSAGE, sizeof(WIFI_CONNECTION_HANDOVER_MESSAGE));
+    // Write the NDEF message (only bytes differing from what is already stored)
+    uint8_t current_message[NBT_IMAGE_NDEF_FILE_SIZE];
+    status = nbt_read_file(nbt, NBT_FILEID_NDEF, 0U, message->length, current_message);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not read NBT NDEF file");
+        return status;
+    }
+    status = nbt_write_file_differences(nbt, NBT_FILEID_NDEF, 0U, current_message, message->data, message->length, NULL);
     if (ifx_error_check(status))
     {
         ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not write NBT NDEF file");
-        goto exit;
+        return status;
     }
-
-exit:
-    *(int *)(arg) = status;
-    return arg;
+    return IFX_SUCCESS;
 }
 
-
-int main()
+/**
+ * \brief Starts a new session with fresh handover credentials (monitor mode, triggered by \c SIGUSR1).
+ * \details Configures the P2P group owner for the new credentials first and only then writes the changed bytes of
+ * the handover message, so the tag never advertises credentials the group owner does not use.
+ *
+ * \param[in] enabled \c false if the NDEF message is not rotated (pregenerated message or \c -F).
+ */
+static void nbt_rotate_session(bool enabled)
 {
-    /** GP T=1' I2C protocol - PSoC&trade;6 Host MCU */
-    // Protocol to handle the GP T=1' I2C protocol communication with tag
-    ifx_protocol_t gp_i2c_protocol;
+    if (!enabled)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Credential rotation disabled, keeping session");
+        return;
+    }
+    if (ifx_error_check(nbt_handover_prepare_rotation(&handover)))
+    {
+        return;
+    }
+    // Ahead of bulk jobs, the rotation has to finish between two taps
+    if (ifx_error_check(nbt_scheduler_execute(&scheduler, NBT_PRIORITY_STATUS, nbt_handover_rotate_job, &handover)))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not write rotated credentials to NDEF file");
+        return;
+    }
+    ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "Session %u: advertising SSID %.*s (patched in %llu us)", handover.rotations,
+                   (int) handover.next.ssid_length, handover.next.ssid, (unsigned long long) handover.last_apply_us);
+}
 
-    // Protocol to handle communication with Raspberry PI I2C driver
-    ifx_protocol_t driver_adapter;
-    /* Initialize protocol driver layer here with I2C implementation.
-    Note: Does not work without initialized driver layer for I2C. */
 
+int main(int argc, char *argv[])
+{
     // code placeholder
     ifx_status_t status;
 
-    /* I2C file descriptor */
-    int i2c_fd;
+    /* Parse command line options */
+    bool monitor = false;
+    const char *dump_path = NULL;
+    const char *restore_path = NULL;
+    bool plan_channel = false;
+    bool plan_only = false;
+    bool allow_5ghz = true;
+    bool allow_ht40 = true;
+    const char *scan_results_path = NULL;
+    const char *pack_path = NULL;
+    const char *device_id = NULL;
+    const char *trace_path = NULL;
+    bool trace_probes = true;
+    bool rotate_credentials = true;
+    bool realtime = false;
+    struct nbt_realtime_config realtime_config = {.priority = NBT_REALTIME_DEFAULT_PRIORITY, .cpu = NBT_REALTIME_NO_CPU};
+    struct nbt_health_config health_config = {.status_path = DEFAULT_STATUS_FILE, .telemetry = &telemetry};
+    long number = 0;
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    long max_cpu = (cpus > 0) ? (cpus - 1L) : 0L;
+    int option;
+    while ((option = getopt(argc, argv, "mi:s:d:r:cS:n2wR:P:k:D:T:xF")) != -1)
+    {
+        switch (option)
+        {
+        case 'm':
+            monitor = true;
+            break;
+        case 'i':
+            if (!parse_number(optarg, 1L, MAX_PROBE_INTERVAL_MS, &number))
+            {
+                fprintf(stderr, "Invalid probe interval %s (expected 1 to %ld ms)\n", optarg, MAX_PROBE_INTERVAL_MS);
+                return EXIT_FAILURE;
+            }
+            health_config.interval_ms = (uint32_t) number;
+            break;
+        case 's':
+            health_config.status_path = optarg;
+            break;
+        case 'd':
+            dump_path = optarg;
+            break;
+        case 'r':
+            restore_path = optarg;
+            break;
+        case 'c':
+            plan_channel = true;
+            break;
+        case 'S':
+            plan_channel = true;
+            scan_results_path = optarg;
+            break;
+        case 'n':
+            plan_channel = true;
+            plan_only = true;
+            break;
+        case '2':
+            allow_5ghz = false;
+            break;
+        case 'w':
+            allow_ht40 = false;
+            break;
+        case 'R':
+            if (!parse_number(optarg, 0L, max_cpu, &number))
+            {
+                fprintf(stderr, "Invalid CPU %s (expected 0 to %ld)\n", optarg, max_cpu);
+                return EXIT_FAILURE;
+            }
+            realtime = true;
+            realtime_config.cpu = (int) number;
+            break;
+        case 'P':
+            if (!parse_number(optarg, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO), &number))
+            {
+                fprintf(stderr, "Invalid real-time priority %s (expected %d to %d)\n", optarg, sched_get_priority_min(SCHED_FIFO),
+                        sched_get_priority_max(SCHED_FIFO));
+                return EXIT_FAILURE;
+            }
+            realtime = true;
+            realtime_config.priority = (int) number;
+            break;
+        case 'k':
+            pack_path = optarg;
+            break;
+        case 'D':
+            device_id = optarg;
+            break;
+        case 'T':
+            trace_path = optarg;
+            break;
+        case 'x':
+            trace_probes = false;
+            break;
+        case 'F':
+            rotate_credentials = false;
+            break;
+        default:
+            fprintf(stderr,
+                    "Usage: %s [-m] [-i probe_interval_ms] [-s status_file] [-d dump_image | -r restore_image] [-c] [-S scan_results] [-n] [-2] [-w] [-R cpu] "
+                    "[-P rt_priority] [-k image_pack -D device_id] [-T trace_file [-x]] [-F]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((pack_path == NULL) != (device_id == NULL))
+    {
+        fprintf(stderr, "Options -k and -D must be given together\n");
+        return EXIT_FAILURE;
+    }
+    if (!trace_probes && (trace_path == NULL))
+    {
+        fprintf(stderr, "Option -x requires -T\n");
+        return EXIT_FAILURE;
+    }
 
-    /* Pthread ID */
-    pthread_t ptid; 
-    void *pthread_status = &status;
+    /* In monitor mode SIGINT / SIGTERM (stop) and SIGUSR1 (new session) are only accepted by sigwait() below, so block them
+     * before any thread is created */
+    sigset_t monitor_signals;
+    sigemptyset(&monitor_signals);
+    sigaddset(&monitor_signals, SIGINT);
+    sigaddset(&monitor_signals, SIGTERM);
+    sigaddset(&monitor_signals, SIGUSR1);
+    if (monitor && (pthread_sigmask(SIG_BLOCK, &monitor_signals, NULL) != 0))
+    {
+        fprintf(stderr, "Could not block monitor signals\n");
+        return EXIT_FAILURE;
+    }
 
     /* Initialize logging */
     status = logger_printf_initialize(ifx_logger_default);
@@ -227,6 +486,69 @@ int main()
         goto ret;
     }
 
+    /* Look up pregenerated message of this device before touching the tag */
+    struct nbt_ndef_message message = {.data = WIFI_CONNECTION_HANDOVER_MESSAGE, .length = sizeof(WIFI_CONNECTION_HANDOVER_MESSAGE)};
+    if (pack_path != NULL)
+    {
+        status = nbt_image_pack_open(&image_pack, pack_path);
+        if (ifx_error_check(status))
+        {
+            goto ret;
+        }
+        status = nbt_image_pack_find(&image_pack, device_id, &message.data, &message.length);
+        if (ifx_error_check(status))
+        {
+            goto ret;
+        }
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "Using %zu byte NDEF message of device %s from %s", message.length, device_id,
+                       pack_path);
+        if (plan_channel)
+        {
+            // The advertised channel is baked into the pregenerated message
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Channel planning ignored for pregenerated messages");
+            plan_channel = false;
+        }
+    }
+
+    /* Choose least congested P2P channel and configure group owner accordingly */
+    struct nbt_channel_plan channel_plan = {0};
+    if (plan_channel)
+    {
+        struct nbt_channel_planner planner;
+        nbt_channel_planner_initialize(&planner, allow_5ghz, allow_ht40);
+        if (scan_results_path != NULL)
+        {
+            FILE *scan_results = fopen(scan_results_path, "r");
+            if (scan_results == NULL)
+            {
+                ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not open scan results %s", scan_results_path);
+                status = IFX_ERROR(LIB_NBT_CHANNEL_PLAN, NBT_CHANNEL_PLAN_SCAN, IFX_ILLEGAL_ARGUMENT);
+                goto ret;
+            }
+            status = nbt_channel_planner_read_scan_results(&planner, scan_results);
+            fclose(scan_results);
+        }
+        else
+        {
+            status = nbt_channel_planner_scan(&planner);
+        }
+        if (ifx_error_check(status))
+        {
+            goto ret;
+        }
+        nbt_channel_planner_choose(&planner, &channel_plan);
+        if (plan_only)
+        {
+            goto ret;
+        }
+        if (ifx_error_check(nbt_channel_plan_apply_go(&channel_plan)))
+        {
+            // Keep advertising the default channel the group owner still uses
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Could not configure P2P group owner channel, keeping default");
+            channel_plan.channel = 0U;
+        }
+    }
+
     /* Open the I2C device */
     if ((i2c_fd = open(RPI_I2C_FILE, O_RDWR)) == -1)
     {
@@ -245,46 +567,202 @@ int main()
         goto exit;
     }
 
+    // Optionally record all T=1' frames below and all APDUs above the T=1' layer
+    ifx_protocol_t *frame_protocol = &driver_adapter;
+    if (trace_path != NULL)
+    {
+        status = nbt_trace_open(&trace, trace_path, NBT_TRACE_DEFAULT_CAPACITY);
+        if (ifx_error_check(status))
+        {
+            ifx_protocol_destroy(&driver_adapter);
+            goto exit;
+        }
+        status = nbt_trace_tap_initialize(&trace_tap, &driver_adapter, &trace);
+        if (ifx_error_check(status))
+        {
+            ifx_protocol_destroy(&driver_adapter);
+            goto exit;
+        }
+        frame_protocol = &trace_tap.protocol;
+    }
+
     // Use GP T=1' protocol channel as a interface to communicate with the OPTIGA&trade; Authenticate NBT
-    status = ifx_t1prime_initialize(&gp_i2c_protocol, &driver_adapter);
+    status = ifx_t1prime_initialize(&gp_i2c_protocol, frame_protocol);
     if (status != IFX_SUCCESS)
     {
+        // Destroys the driver adapter (also if wrapped by the trace tap)
+        ifx_protocol_destroy(frame_protocol);
         goto exit;
     }
 
     ifx_protocol_set_logger(&gp_i2c_protocol, ifx_logger_default);
-    status = ifx_protocol_activate(&gp_i2c_protocol, NULL, NULL);
+
+    ifx_protocol_t *apdu_protocol = &gp_i2c_protocol;
+    if (trace_path != NULL)
+    {
+        status = nbt_trace_initialize(&trace_protocol, &gp_i2c_protocol, &trace);
+        if (ifx_error_check(status))
+        {
+            ifx_protocol_destroy(&gp_i2c_protocol);
+            goto exit;
+        }
+        apdu_protocol = &trace_protocol;
+    }
+
+    // Lock the I2C bus against other processes for every APDU exchange
+    status = nbt_bus_lock_initialize(&bus_lock_protocol, apdu_protocol, RPI_I2C_FILE, NBT_BUS_LOCK_DEFAULT_TIMEOUT_MS);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not initialize I2C bus lock");
+        ifx_protocol_destroy(apdu_protocol);
+        goto exit;
+    }
+    status = ifx_protocol_activate(&bus_lock_protocol, NULL, NULL);
     if (status != IFX_SUCCESS)
     {
         goto cleanup;
     }
 
     // NBT command abstraction
-    status = nbt_initialize(&nbt, &gp_i2c_protocol, ifx_logger_default);
+    status = nbt_initialize(&nbt, &bus_lock_protocol, ifx_logger_default);
     if (ifx_error_check(status))
     {
         ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not initialize NBT abstraction");
         goto cleanup;
     }
 
-    /* Create a thread to perform nbt_write_ndef function */
-    if (0 != pthread_create(&ptid, NULL, nbt_write_ndef, pthread_status))
+    /* Index mutable handover fields, advertise the planned channel and rotate credentials (pregenerated messages are written as is) */
+    if (pack_path == NULL)
+    {
+        status = nbt_handover_initialize(&handover, WIFI_CONNECTION_HANDOVER_MESSAGE, sizeof(WIFI_CONNECTION_HANDOVER_MESSAGE));
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not index WiFi connection handover message");
+            goto cleanup;
+        }
+        struct nbt_handover_credentials credentials;
+        nbt_handover_get_credentials(&handover, &credentials);
+        if (channel_plan.channel != 0U)
+        {
+            credentials.channel = channel_plan.channel;
+            credentials.rf_bands = channel_plan.rf_bands;
+            nbt_handover_patch(&handover, &credentials, WIFI_CONNECTION_HANDOVER_MESSAGE);
+        }
+        // New session credentials are only advertised once the group owner uses them
+        if (rotate_credentials && !ifx_error_check(nbt_handover_prepare_rotation(&handover)))
+        {
+            credentials = handover.next;
+            nbt_handover_patch(&handover, &credentials, WIFI_CONNECTION_HANDOVER_MESSAGE);
+        }
+        else if (rotate_credentials)
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Could not rotate credentials, keeping encoded SSID");
+        }
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "Advertising SSID %.*s on channel %u", (int) credentials.ssid_length, credentials.ssid,
+                       credentials.channel);
+    }
+
+    status = nbt_ringlog_initialize(&telemetry, NBT_FILEID_PROPRIETARY1, NBT_RINGLOG_MAX_SLOTS, 0U);
+    if (ifx_error_check(status))
     {
-        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not create POSIX thread");
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not initialize telemetry ring log");
         goto cleanup;
     }
 
-    /* Wait till thread completion. Should not come here */
-    pthread_join(ptid, &pthread_status);
-    if (*(int*)pthread_status)
+    /* Hand NBT abstraction over to the scheduler's I/O thread (optionally with real-time scheduling) */
+    if (realtime)
+    {
+        scheduler.thread_hook = nbt_realtime_thread_hook;
+        scheduler.thread_hook_context = &realtime_config;
+    }
+    if ((trace_path != NULL) && !trace_probes)
     {
-        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "POSIX thread: nbt_write_ndef failed with: (%d)", *(int *)pthread_status);
+        scheduler.job_hook = trace_exclude_probes;
+        scheduler.job_hook_context = &trace;
     }
+    status = nbt_scheduler_start(&scheduler, &nbt);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not start NBT scheduler");
+        nbt_ringlog_destroy(&telemetry);
+        goto cleanup;
+    }
+
+    /* Dump or restore complete tag image instead of provisioning */
+    if (dump_path != NULL)
+    {
+        status = nbt_scheduler_execute(&scheduler, NBT_PRIORITY_BULK, nbt_image_dump_job, (void *) dump_path);
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not dump NBT image to %s", dump_path);
+        }
+        goto stop;
+    }
+    if (restore_path != NULL)
+    {
+        status = nbt_scheduler_execute(&scheduler, NBT_PRIORITY_BULK, nbt_image_restore_job, (void *) restore_path);
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not restore NBT image from %s", restore_path);
+        }
+        goto stop;
+    }
+
+    /* Write connection handover message as bulk job */
+    status = nbt_scheduler_execute(&scheduler, NBT_PRIORITY_BULK, nbt_write_ndef, &message);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "NBT job nbt_write_ndef failed with: (0x%08X)", status);
+    }
+    else
+    {
+        /* Record handover provisioning in telemetry ring (batched into a single write) */
+        uint8_t event = TELEMETRY_EVENT_STARTUP;
+        nbt_ringlog_append(&telemetry, NBT_RINGLOG_TYPE_EVENT, &event, sizeof(event), NULL);
+        event = TELEMETRY_EVENT_NDEF_WRITTEN;
+        nbt_ringlog_append(&telemetry, NBT_RINGLOG_TYPE_EVENT, &event, sizeof(event), NULL);
+        if (ifx_error_check(nbt_scheduler_execute(&scheduler, NBT_PRIORITY_STATUS, nbt_ringlog_flush_job, &telemetry)))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Could not flush telemetry ring log");
+        }
+
+        /* Keep probing tag liveness on the existing session until SIGINT / SIGTERM */
+        if (monitor)
+        {
+            status = nbt_health_start(&health, &scheduler, &bus_lock_protocol, &health_config);
+            if (ifx_error_check(status))
+            {
+                ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not start health monitor");
+            }
+            else
+            {
+                ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "Monitoring NBT, status exported to %s", health_config.status_path);
+                int signal_number = 0;
+                while ((sigwait(&monitor_signals, &signal_number) == 0) && (signal_number == SIGUSR1))
+                {
+                    nbt_rotate_session((pack_path == NULL) && rotate_credentials);
+                }
+                ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "Received signal %d, stopping health monitor", signal_number);
+                struct nbt_health_report report;
+                nbt_health_get_report(&health, &report);
+                nbt_health_stop(&health);
+                ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO,
+                               "Health: %llu probes, %llu failures, %llu reactivations, p50 %u us, p99 %u us",
+                               (unsigned long long) report.probes, (unsigned long long) report.failures,
+                               (unsigned long long) report.reactivations, report.p50_us, report.p99_us);
+            }
+        }
+    }
+
+stop:
+    /* Drain remaining jobs and stop I/O thread */
+    nbt_scheduler_stop(&scheduler);
+    nbt_ringlog_destroy(&telemetry);
 
 cleanup:
 
-    // Perform cleanup of full protocol stack
-    ifx_protocol_destroy(&gp_i2c_protocol);
+    // Perform cleanup of full protocol stack (bus lock layer and everything below)
+    ifx_protocol_destroy(&bus_lock_protocol);
 
     // Destroy NBT command abstraction
     nbt_destroy(&nbt);
@@ -293,5 +771,7 @@ exit:
     close(i2c_fd);
 
 ret:
+    nbt_trace_close(&trace);
+    nbt_image_pack_close(&image_pack);
     return status;
 }
@@ -0,0 +1,407 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-bus-lock-test.c
+ * \brief Multi-process test of the bus lock protocol layer (no hardware required).
+ *
+ * \details Two scenarios on a temporary lock file:
+ *
+ *   * Mutual exclusion: several forked workers exchange APDUs through their own bus lock layer. The scripted transport
+ *     below each layer counts the exchanges in flight in shared memory, so any overlap between two processes fails the
+ *     test.
+ *   * Timeout: another process holds the lock, an exchange has to fail with \c NBT_BUS_LOCK_TIMEOUT after the
+ *     configured timeout without reaching the transport and has to succeed once the lock is released.
+ *   * Fairness: another process keeps re-locking the bus right after releasing it. Waiting exchanges have to be
+ *     served within a few of its lock periods instead of starving until the timeout.
+ *
+ * Returns a non-zero exit code if any check fails.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-protocol.h"
+#include "infineon/logger-printf.h"
+
+#include "../utilities/nbt-bus-lock.h"
+
+/* Number of concurrent worker processes */
+#define WORKERS 4U
+
+/* Number of APDU exchanges per worker */
+#define EXCHANGES_PER_WORKER 200U
+
+/* Emulated duration of a single exchange in nanoseconds */
+#define EXCHANGE_TIME_NS 100000L
+
+/* Lock timeout of the workers in milliseconds (never expected to expire) */
+#define WORKER_TIMEOUT_MS 10000U
+
+/* Lock timeout of the timeout scenario in milliseconds */
+#define TIMEOUT_MS 200U
+
+/* Number of exchanges competing with the re-locking process */
+#define FAIRNESS_EXCHANGES 50U
+
+/* Time the re-locking process holds the lock in nanoseconds */
+#define FAIRNESS_HOLD_NS 1000000L
+
+/* Longest accepted wait for the lock in the fairness scenario in milliseconds */
+#define FAIRNESS_MAX_WAIT_MS 50U
+
+/**
+ * \brief Counters shared between all processes (anonymous shared mapping).
+ */
+struct shared_state
+{
+    /* Number of exchanges currently inside the transport */
+    unsigned int in_flight;
+
+    /* Largest number of exchanges ever inside the transport at the same time */
+    unsigned int max_in_flight;
+
+    /* Number of completed exchanges */
+    unsigned long long exchanges;
+
+    /* Number of contended acquisitions reported by the workers */
+    unsigned long long contended;
+
+    /* Set to stop the re-locking process of the fairness scenario */
+    bool stop;
+};
+
+static struct shared_state *shared;
+
+/* Arbitrary command, the transport does not interpret it */
+static const uint8_t COMMAND[] = {0x00U, 0xB0U, 0x00U, 0x00U, 0x02U};
+
+/**
+ * \brief Returns current \c CLOCK_MONOTONIC time in nanoseconds.
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000U) + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * \brief Prints failed check.
+ *
+ * \return bool \c condition.
+ */
+static bool check(bool condition, const char *description)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", description);
+    }
+    return condition;
+}
+
+/**
+ * \brief Scripted APDU exchange tracking overlapping exchanges and answering with status word 9000.
+ */
+static ifx_status_t transport_transceive(ifx_protocol_t *self, const uint8_t *data, size_t data_len, uint8_t **response, size_t *response_len)
+{
+    (void) self;
+    (void) data;
+    (void) data_len;
+    unsigned int in_flight = __atomic_add_fetch(&shared->in_flight, 1U, __ATOMIC_SEQ_CST);
+    unsigned int max_in_flight = __atomic_load_n(&shared->max_in_flight, __ATOMIC_SEQ_CST);
+    while ((in_flight > max_in_flight) &&
+           !__atomic_compare_exchange_n(&shared->max_in_flight, &max_in_flight, in_flight, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+    }
+    struct timespec delay = {.tv_sec = 0, .tv_nsec = EXCHANGE_TIME_NS};
+    nanosleep(&delay, NULL);
+    __atomic_sub_fetch(&shared->in_flight, 1U, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&shared->exchanges, 1U, __ATOMIC_SEQ_CST);
+
+    *response = (uint8_t *) malloc(2U);
+    if (*response == NULL)
+    {
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_ACQUIRE, IFX_OUT_OF_MEMORY);
+    }
+    (*response)[0] = 0x90U;
+    (*response)[1] = 0x00U;
+    *response_len = 2U;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Initializes scripted transport with a bus lock layer on top.
+ */
+static ifx_status_t stack_initialize(ifx_protocol_t *bus_lock, ifx_protocol_t *transport, const char *lock_path, uint32_t timeout_ms)
+{
+    ifx_status_t status = ifx_protocol_layer_initialize(transport);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    transport->_transceive = transport_transceive;
+    return nbt_bus_lock_initialize(bus_lock, transport, lock_path, timeout_ms);
+}
+
+/**
+ * \brief Exchanges a single command through the protocol stack.
+ */
+static ifx_status_t exchange(ifx_protocol_t *protocol)
+{
+    uint8_t *response = NULL;
+    size_t response_len = 0U;
+    ifx_status_t status = ifx_protocol_transceive(protocol, COMMAND, sizeof(COMMAND), &response, &response_len);
+    free(response);
+    return status;
+}
+
+/**
+ * \brief Worker process exchanging APDUs through its own bus lock layer.
+ *
+ * \return int Process exit code.
+ */
+static int run_worker(const char *lock_path)
+{
+    ifx_protocol_t transport;
+    ifx_protocol_t bus_lock;
+    if (ifx_error_check(stack_initialize(&bus_lock, &transport, lock_path, WORKER_TIMEOUT_MS)))
+    {
+        return EXIT_FAILURE;
+    }
+    size_t failures = 0U;
+    for (size_t i = 0U; i < EXCHANGES_PER_WORKER; i++)
+    {
+        if (ifx_error_check(exchange(&bus_lock)))
+        {
+            failures++;
+        }
+    }
+    struct nbt_bus_lock_metrics metrics;
+    bool passed = !ifx_error_check(nbt_bus_lock_get_metrics(&bus_lock, &metrics));
+    passed = check(passed && (failures == 0U), "worker exchange failed") && passed;
+    passed = check(passed && (metrics.acquisitions == EXCHANGES_PER_WORKER) && (metrics.timeouts == 0U), "worker metrics mismatch") && passed;
+    if (passed)
+    {
+        __atomic_add_fetch(&shared->contended, metrics.contended, __ATOMIC_SEQ_CST);
+    }
+    ifx_protocol_destroy(&bus_lock);
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \brief Runs concurrent workers and checks that no two exchanges overlapped.
+ *
+ * \return bool \c true if all checks passed.
+ */
+static bool test_mutual_exclusion(const char *lock_path)
+{
+    pid_t workers[WORKERS];
+    size_t started = 0U;
+    for (; started < WORKERS; started++)
+    {
+        workers[started] = fork();
+        if (workers[started] == 0)
+        {
+            _exit(run_worker(lock_path));
+        }
+        if (workers[started] == -1)
+        {
+            perror("fork");
+            break;
+        }
+    }
+    bool passed = check(started == WORKERS, "could not start all workers");
+    for (size_t i = 0U; i < started; i++)
+    {
+        int wait_status = 0;
+        waitpid(workers[i], &wait_status, 0);
+        passed = check(WIFEXITED(wait_status) && (WEXITSTATUS(wait_status) == EXIT_SUCCESS), "worker failed") && passed;
+    }
+    passed = check(shared->max_in_flight == 1U, "exchanges of different processes overlapped") && passed;
+    passed = check(shared->exchanges == ((unsigned long long) WORKERS * EXCHANGES_PER_WORKER), "exchanges lost") && passed;
+    printf("mutual exclusion: %llu exchanges, %llu contended acquisitions, max %u in flight\n", shared->exchanges, shared->contended,
+           shared->max_in_flight);
+    return passed;
+}
+
+/**
+ * \brief Holds the lock from another process and checks timeout and recovery.
+ *
+ * \return bool \c true if all checks passed.
+ */
+static bool test_timeout(const char *lock_path)
+{
+    int ready[2];
+    if (pipe(ready) != 0)
+    {
+        perror("pipe");
+        return false;
+    }
+    pid_t holder = fork();
+    if (holder == 0)
+    {
+        int fd = open(lock_path, O_RDONLY | O_CLOEXEC);
+        char signal_byte = 1;
+        if ((fd == -1) || (flock(fd, LOCK_EX) != 0) || (write(ready[1], &signal_byte, 1U) != 1))
+        {
+            _exit(EXIT_FAILURE);
+        }
+        for (;;)
+        {
+            pause();
+        }
+    }
+    close(ready[1]);
+    char signal_byte = 0;
+    bool passed = check((holder != -1) && (read(ready[0], &signal_byte, 1U) == 1), "lock holder did not start");
+    close(ready[0]);
+    if (!passed)
+    {
+        if (holder != -1)
+        {
+            kill(holder, SIGKILL);
+            waitpid(holder, NULL, 0);
+        }
+        return false;
+    }
+
+    ifx_protocol_t transport;
+    ifx_protocol_t bus_lock;
+    bool initialized = check(!ifx_error_check(stack_initialize(&bus_lock, &transport, lock_path, TIMEOUT_MS)), "could not initialize bus lock");
+    passed = initialized;
+    if (initialized)
+    {
+        unsigned long long exchanges = shared->exchanges;
+        uint64_t start = now_ns();
+        ifx_status_t status = exchange(&bus_lock);
+        uint64_t waited_ms = (now_ns() - start) / 1000000U;
+        passed = check(status == IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_ACQUIRE, NBT_BUS_LOCK_TIMEOUT), "locked bus did not time out") && passed;
+        passed = check((waited_ms >= TIMEOUT_MS) && (waited_ms < (10U * TIMEOUT_MS)), "timeout not honoured") && passed;
+        passed = check(shared->exchanges == exchanges, "transport used without lock") && passed;
+        printf("timeout: failed after %llu ms (timeout %u ms)\n", (unsigned long long) waited_ms, TIMEOUT_MS);
+    }
+
+    kill(holder, SIGKILL);
+    waitpid(holder, NULL, 0);
+    if (initialized)
+    {
+        passed = check(!ifx_error_check(exchange(&bus_lock)), "exchange failed after lock was released") && passed;
+        struct nbt_bus_lock_metrics metrics;
+        passed = check(!ifx_error_check(nbt_bus_lock_get_metrics(&bus_lock, &metrics)) && (metrics.timeouts == 1U) && (metrics.acquisitions == 1U),
+                       "timeout metrics mismatch") &&
+                 passed;
+        ifx_protocol_destroy(&bus_lock);
+    }
+    return passed;
+}
+
+/**
+ * \brief Competes with a process re-locking the bus immediately after every release and checks the waiting time.
+ *
+ * \return bool \c true if all checks passed.
+ */
+static bool test_fairness(const char *lock_path)
+{
+    __atomic_store_n(&shared->stop, false, __ATOMIC_SEQ_CST);
+    pid_t hog = fork();
+    if (hog == 0)
+    {
+        int fd = open(lock_path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            _exit(EXIT_FAILURE);
+        }
+        while (!__atomic_load_n(&shared->stop, __ATOMIC_SEQ_CST))
+        {
+            if (flock(fd, LOCK_EX) != 0)
+            {
+                _exit(EXIT_FAILURE);
+            }
+            struct timespec hold = {.tv_sec = 0, .tv_nsec = FAIRNESS_HOLD_NS};
+            nanosleep(&hold, NULL);
+            flock(fd, LOCK_UN);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+    if (!check(hog != -1, "could not start re-locking process"))
+    {
+        return false;
+    }
+
+    ifx_protocol_t transport;
+    ifx_protocol_t bus_lock;
+    bool passed = check(!ifx_error_check(stack_initialize(&bus_lock, &transport, lock_path, WORKER_TIMEOUT_MS)), "could not initialize bus lock");
+    if (passed)
+    {
+        size_t failures = 0U;
+        for (size_t i = 0U; i < FAIRNESS_EXCHANGES; i++)
+        {
+            if (ifx_error_check(exchange(&bus_lock)))
+            {
+                failures++;
+            }
+        }
+        struct nbt_bus_lock_metrics metrics = {0};
+        passed = check(!ifx_error_check(nbt_bus_lock_get_metrics(&bus_lock, &metrics)) && (failures == 0U), "exchange failed") && passed;
+        uint64_t wait_max_ms = metrics.wait_max_ns / 1000000U;
+        passed = check(wait_max_ms < FAIRNESS_MAX_WAIT_MS, "waiting exchange starved") && passed;
+        printf("fairness: %llu of %u acquisitions contended, wait avg/max %llu/%llu us\n", (unsigned long long) metrics.contended, FAIRNESS_EXCHANGES,
+               (unsigned long long) ((metrics.acquisitions > 0U) ? (metrics.wait_total_ns / metrics.acquisitions / 1000U) : 0U),
+               (unsigned long long) (metrics.wait_max_ns / 1000U));
+        ifx_protocol_destroy(&bus_lock);
+    }
+
+    __atomic_store_n(&shared->stop, true, __ATOMIC_SEQ_CST);
+    int wait_status = 0;
+    waitpid(hog, &wait_status, 0);
+    return check(WIFEXITED(wait_status) && (WEXITSTATUS(wait_status) == EXIT_SUCCESS), "re-locking process failed") && passed;
+}
+
+int main(void)
+{
+    ifx_status_t status = logger_printf_initialize(ifx_logger_default);
+    if (ifx_error_check(status))
+    {
+        return EXIT_FAILURE;
+    }
+    // The timeout scenario logs an error on purpose
+    ifx_logger_set_level(ifx_logger_default, IFX_LOG_FATAL);
+
+    char lock_path[] = "/tmp/nbt-bus-lock-test-XXXXXX";
+    int fd = mkstemp(lock_path);
+    if (fd == -1)
+    {
+        perror("mkstemp");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+    shared = (struct shared_state *) mmap(NULL, sizeof(struct shared_state), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        perror("mmap");
+        unlink(lock_path);
+        return EXIT_FAILURE;
+    }
+    memset(shared, 0, sizeof(struct shared_state));
+
+    bool passed = test_mutual_exclusion(lock_path);
+    passed = test_timeout(lock_path) && passed;
+    passed = test_fairness(lock_path) && passed;
+
+    munmap(shared, sizeof(struct shared_state));
+    unlink(lock_path);
+    printf("%s\n", passed ? "PASS" : "FAIL");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-channel-plan-test.c
+ * \brief Replays recorded scan results through the channel planner (no WiFi hardware required).
+ *
+ * \details Usage: \c nbt-channel-plan-test \c <fixture-directory>
+ *
+ * The fixture directory contains recorded \c "wpa_cli scan_results" and \c "iw dev <interface> scan" outputs and a
+ * file \c expected.txt with one check per line (\c # starts a comment):
+ *
+ *   <fixture> <5ghz|2.4ghz> <ht40|20mhz> <channel> <rf bands> <operating class>
+ *
+ * Returns a non-zero exit code if any check fails.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/logger-printf.h"
+
+#include "../utilities/nbt-channel-plan.h"
+
+/**
+ * \brief Name of the file with the expected plans within the fixture directory.
+ */
+#define EXPECTED_FILE "expected.txt"
+
+/**
+ * \brief Runs planner on a single fixture and compares the chosen plan.
+ *
+ * \return bool \c true if the check passed.
+ */
+static bool check_fixture(const char *directory, const char *fixture, bool allow_5ghz, bool ht40, unsigned int channel, unsigned int rf_bands,
+                          unsigned int operating_class)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", directory, fixture);
+    FILE *scan_results = fopen(path, "r");
+    if (scan_results == NULL)
+    {
+        printf("FAIL: %s: could not open fixture\n", fixture);
+        return false;
+    }
+    struct nbt_channel_planner planner;
+    nbt_channel_planner_initialize(&planner, allow_5ghz, ht40);
+    ifx_status_t status = nbt_channel_planner_read_scan_results(&planner, scan_results);
+    fclose(scan_results);
+    if (ifx_error_check(status))
+    {
+        printf("FAIL: %s: could not read scan results\n", fixture);
+        return false;
+    }
+    struct nbt_channel_plan plan;
+    nbt_channel_planner_choose(&planner, &plan);
+    bool passed = (plan.channel == channel) && (plan.rf_bands == rf_bands) && (plan.operating_class == operating_class);
+    printf("%s: %s %s %s: channel %u, bands 0x%02X, operating class %u", passed ? "ok" : "FAIL", fixture, allow_5ghz ? "5ghz" : "2.4ghz",
+           ht40 ? "ht40" : "20mhz", plan.channel, plan.rf_bands, plan.operating_class);
+    if (!passed)
+    {
+        printf(" (expected channel %u, bands 0x%02X, operating class %u)", channel, rf_bands, operating_class);
+    }
+    printf("\n");
+    return passed;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <fixture-directory>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    ifx_status_t status = logger_printf_initialize(ifx_logger_default);
+    if (ifx_error_check(status))
+    {
+        return EXIT_FAILURE;
+    }
+    ifx_logger_set_level(ifx_logger_default, IFX_LOG_FATAL);
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", argv[1], EXPECTED_FILE);
+    FILE *expected = fopen(path, "r");
+    if (expected == NULL)
+    {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    bool passed = true;
+    size_t checks = 0U;
+    char line[256];
+    for (size_t line_number = 1U; fgets(line, sizeof(line), expected) != NULL; line_number++)
+    {
+        char fixture[128];
+        char band[8];
+        char width[8];
+        unsigned int channel;
+        unsigned int rf_bands;
+        unsigned int operating_class;
+        if ((line[strspn(line, " \t\r\n")] == '\0') || (line[strspn(line, " \t")] == '#'))
+        {
+            continue;
+        }
+        if ((sscanf(line, "%127s %7s %7s %u %x %u", fixture, band, width, &channel, &rf_bands, &operating_class) != 6) ||
+            ((strcmp(band, "5ghz") != 0) && (strcmp(band, "2.4ghz") != 0)) || ((strcmp(width, "ht40") != 0) && (strcmp(width, "20mhz") != 0)))
+        {
+            printf("FAIL: " EXPECTED_FILE ":%zu: malformed check\n", line_number);
+            passed = false;
+            continue;
+        }
+        passed = check_fixture(argv[1], fixture, strcmp(band, "5ghz") == 0, strcmp(width, "ht40") == 0, channel, rf_bands, operating_class) && passed;
+        checks++;
+    }
+    fclose(expected);
+    passed = passed && (checks > 0U);
+    printf("%s (%zu checks)\n", passed ? "PASS" : "FAIL", checks);
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
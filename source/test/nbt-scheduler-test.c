@@ -0,0 +1,223 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-scheduler-test.c
+ * \brief Priority order of the NBT command scheduler (no hardware required).
+ *
+ * \details A blocking job keeps the I/O thread busy while jobs of all priorities are queued in reverse priority order,
+ * the pass-through job last. Once released, the jobs have to complete strictly by priority, starting with the
+ * pass-through job, which has to reach the (scripted) transport with its fetch and response commands, and ending with the
+ * health probes.
+ *
+ * Returns a non-zero exit code if any check fails.
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-protocol.h"
+#include "infineon/logger-printf.h"
+#include "infineon/nbt-cmd.h"
+
+#include "../utilities/nbt-scheduler.h"
+
+/* Number of queued jobs per priority */
+#define JOBS_PER_PRIORITY 3U
+
+/* Total number of jobs (blocking job included) */
+#define MAX_JOBS ((JOBS_PER_PRIORITY * NBT_PRIORITY_COUNT) + 1U)
+
+/**
+ * \brief Completed job as recorded by its completion callback.
+ */
+struct completed_job
+{
+    /* Priority the job was queued with */
+    enum nbt_scheduler_priority priority;
+
+    /* Number of commands the transport has seen when the job completed */
+    size_t commands;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t released_signal = PTHREAD_COND_INITIALIZER;
+static bool released;
+static struct completed_job completed[MAX_JOBS];
+static size_t completed_count;
+static size_t commands;
+
+/* Priorities passed as job context (addresses must stay valid until completion) */
+static const enum nbt_scheduler_priority PRIORITIES[NBT_PRIORITY_COUNT] = {NBT_PRIORITY_PASS_THROUGH, NBT_PRIORITY_STATUS, NBT_PRIORITY_BULK,
+                                                                          NBT_PRIORITY_PROBE};
+
+/**
+ * \brief Prints failed check.
+ *
+ * \return bool \c condition.
+ */
+static bool check(bool condition, const char *description)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", description);
+    }
+    return condition;
+}
+
+/**
+ * \brief Scripted transport counting commands and answering every command with status word 9000.
+ */
+static ifx_status_t transport_transceive(ifx_protocol_t *self, const uint8_t *data, size_t data_len, uint8_t **response, size_t *response_len)
+{
+    (void) self;
+    (void) data;
+    (void) data_len;
+    pthread_mutex_lock(&lock);
+    commands++;
+    pthread_mutex_unlock(&lock);
+    *response = (uint8_t *) malloc(2U);
+    if (*response == NULL)
+    {
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_EXECUTE, IFX_OUT_OF_MEMORY);
+    }
+    (*response)[0] = 0x90U;
+    (*response)[1] = 0x00U;
+    *response_len = 2U;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Pass-through handler answering every command with status word 9000.
+ */
+static ifx_status_t pass_through_handler(const ifx_apdu_t *command, ifx_apdu_response_t *response, void *context)
+{
+    (void) command;
+    (void) context;
+    response->data = NULL;
+    response->len = 0U;
+    response->sw = 0x9000U;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Job blocking the I/O thread until all other jobs have been queued.
+ */
+static ifx_status_t blocking_job(nbt_cmd_t *nbt, void *context)
+{
+    (void) nbt;
+    (void) context;
+    pthread_mutex_lock(&lock);
+    while (!released)
+    {
+        pthread_cond_wait(&released_signal, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Job doing nothing (its completion records the order).
+ */
+static ifx_status_t empty_job(nbt_cmd_t *nbt, void *context)
+{
+    (void) nbt;
+    (void) context;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Records completed job (context is a pointer into PRIORITIES).
+ */
+static void record_completion(ifx_status_t status, void *context)
+{
+    (void) status;
+    pthread_mutex_lock(&lock);
+    if (completed_count < MAX_JOBS)
+    {
+        completed[completed_count].priority = *(const enum nbt_scheduler_priority *) context;
+        completed[completed_count].commands = commands;
+        completed_count++;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * \brief Records completed pass-through job.
+ */
+static void record_pass_through_completion(ifx_status_t status, void *context)
+{
+    (void) context;
+    record_completion(status, (void *) &PRIORITIES[NBT_PRIORITY_PASS_THROUGH]);
+}
+
+int main(void)
+{
+    ifx_status_t status = logger_printf_initialize(ifx_logger_default);
+    if (ifx_error_check(status))
+    {
+        return EXIT_FAILURE;
+    }
+    ifx_logger_set_level(ifx_logger_default, IFX_LOG_FATAL);
+
+    ifx_protocol_t transport;
+    nbt_cmd_t nbt;
+    status = ifx_protocol_layer_initialize(&transport);
+    if (!ifx_error_check(status))
+    {
+        transport._transceive = transport_transceive;
+        status = nbt_initialize(&nbt, &transport, ifx_logger_default);
+    }
+    struct nbt_scheduler scheduler = {0};
+    if (ifx_error_check(status) || ifx_error_check(nbt_scheduler_start(&scheduler, &nbt)))
+    {
+        printf("FAIL: could not start scheduler\n");
+        return EXIT_FAILURE;
+    }
+
+    // Block I/O thread, then queue lowest priority first and the pass-through job last
+    bool passed = check(!ifx_error_check(nbt_scheduler_submit(&scheduler, NBT_PRIORITY_BULK, blocking_job, record_completion,
+                                                               (void *) &PRIORITIES[NBT_PRIORITY_BULK])),
+                        "could not queue blocking job");
+    for (size_t priority = NBT_PRIORITY_COUNT - 1U; priority > NBT_PRIORITY_PASS_THROUGH; priority--)
+    {
+        for (size_t i = 0U; i < JOBS_PER_PRIORITY; i++)
+        {
+            passed = check(!ifx_error_check(nbt_scheduler_submit(&scheduler, (enum nbt_scheduler_priority) priority, empty_job, record_completion,
+                                                                 (void *) &PRIORITIES[priority])),
+                           "could not queue job") &&
+                     passed;
+        }
+    }
+    struct nbt_pass_through pass_through = {.handler = pass_through_handler, .context = NULL};
+    for (size_t i = 0U; i < JOBS_PER_PRIORITY; i++)
+    {
+        passed = check(!ifx_error_check(nbt_scheduler_submit(&scheduler, NBT_PRIORITY_PASS_THROUGH, nbt_scheduler_pass_through_job,
+                                                             record_pass_through_completion, &pass_through)),
+                       "could not queue pass-through job") &&
+                 passed;
+    }
+    pthread_mutex_lock(&lock);
+    released = true;
+    pthread_cond_broadcast(&released_signal);
+    pthread_mutex_unlock(&lock);
+    nbt_scheduler_stop(&scheduler);
+
+    passed = check(completed_count == MAX_JOBS, "jobs lost") && passed;
+    passed = check((completed_count > 1U) && (completed[1].priority == NBT_PRIORITY_PASS_THROUGH), "pass-through job did not run first") && passed;
+    for (size_t i = 2U; i < completed_count; i++)
+    {
+        passed = check(completed[i].priority >= completed[i - 1U].priority, "jobs not executed by priority") && passed;
+    }
+    passed = check((completed_count > 1U) && (completed[1].commands > completed[0].commands), "pass-through job did not reach the NBT") && passed;
+    passed = check((completed_count > 0U) && (completed[completed_count - 1U].priority == NBT_PRIORITY_PROBE), "probe jobs did not run last") && passed;
+    printf("%zu jobs executed in priority order, %zu commands sent\n", completed_count, commands);
+
+    nbt_destroy(&nbt);
+    printf("%s\n", passed ? "PASS" : "FAIL");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
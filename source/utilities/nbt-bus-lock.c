@@ -0,0 +1,383 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-bus-lock.c
+ * \brief Protocol layer arbitrating a shared I2C bus between processes.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-logger.h"
+#include "infineon/ifx-protocol.h"
+
+#include "nbt-bus-lock.h"
+
+/**
+ * \brief String used as source information for logging.
+ */
+#define LOG_TAG "NBT bus lock"
+
+/**
+ * \brief Interval in nanoseconds at which the wait timer keeps interrupting a blocked flock() once the timeout expired.
+ *
+ * \details Covers the signal arriving right before the waiting thread entered flock().
+ */
+#define NBT_BUS_LOCK_TIMER_INTERVAL_NS 10000000L
+
+// Older C libraries only provide the union member
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/** \struct nbt_bus_lock_properties
+ * \brief Layer state stored in ifx_protocol_t._properties.
+ */
+struct nbt_bus_lock_properties
+{
+    /**
+     * \brief File descriptor of lock file.
+     */
+    int fd;
+
+    /**
+     * \brief Maximum time to wait for the lock in nanoseconds.
+     */
+    uint64_t timeout_ns;
+
+    /**
+     * \brief Time the lock has been acquired (valid while held).
+     */
+    struct timespec acquired_at;
+
+    /**
+     * \brief Lock protecting nbt_bus_lock_properties.metrics against concurrent readers.
+     */
+    pthread_mutex_t metrics_lock;
+
+    /**
+     * \brief Wait and hold time statistics.
+     */
+    struct nbt_bus_lock_metrics metrics;
+};
+
+/**
+ * \brief Returns nanoseconds elapsed between two timestamps.
+ *
+ * \param[in] start Start time.
+ * \param[in] end End time.
+ * \return uint64_t Elapsed nanoseconds.
+ */
+static uint64_t nbt_bus_lock_elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return ((uint64_t) (end->tv_sec - start->tv_sec) * 1000000000U) + (uint64_t) end->tv_nsec - (uint64_t) start->tv_nsec;
+}
+
+/**
+ * \brief Handler of \c NBT_BUS_LOCK_TIMEOUT_SIGNAL, only interrupts a blocked flock().
+ *
+ * \param[in] signal_number Received signal.
+ */
+static void nbt_bus_lock_timeout_handler(int signal_number)
+{
+    (void) signal_number;
+}
+
+/**
+ * \brief Blocks in flock() until the lock is granted or the configured timeout expires.
+ *
+ * \details The kernel queues blocked waiters and wakes them as soon as the lock is released, so waiters are not starved
+ * by processes re-locking the bus right away. A timer sending \c NBT_BUS_LOCK_TIMEOUT_SIGNAL to the calling thread
+ * interrupts flock() once the timeout expired.
+ *
+ * \param[in] properties Layer state.
+ * \param[in] start Time the first lock attempt was made.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_bus_lock_wait(struct nbt_bus_lock_properties *properties, const struct timespec *start)
+{
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = NBT_BUS_LOCK_TIMEOUT_SIGNAL;
+    event.sigev_notify_thread_id = (pid_t) syscall(SYS_gettid);
+    timer_t timer;
+    if (timer_create(CLOCK_MONOTONIC, &event, &timer) != 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not create bus lock timer: %s", strerror(errno));
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_ACQUIRE, IFX_UNSPECIFIED_ERROR);
+    }
+    uint64_t deadline_ns = ((uint64_t) start->tv_sec * 1000000000U) + (uint64_t) start->tv_nsec + properties->timeout_ns;
+    struct itimerspec expiry = {.it_value = {.tv_sec = (time_t) (deadline_ns / 1000000000U), .tv_nsec = (long) (deadline_ns % 1000000000U)},
+                                .it_interval = {.tv_sec = 0, .tv_nsec = NBT_BUS_LOCK_TIMER_INTERVAL_NS}};
+    if (timer_settime(timer, TIMER_ABSTIME, &expiry, NULL) != 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not start bus lock timer: %s", strerror(errno));
+        timer_delete(timer);
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_ACQUIRE, IFX_UNSPECIFIED_ERROR);
+    }
+
+    bool expired = false;
+    int result;
+    while (((result = flock(properties->fd, LOCK_EX)) != 0) && (errno == EINTR))
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (nbt_bus_lock_elapsed_ns(start, &now) >= properties->timeout_ns)
+        {
+            expired = true;
+            break;
+        }
+    }
+    int error = errno;
+    timer_delete(timer);
+
+    if (expired)
+    {
+        pthread_mutex_lock(&properties->metrics_lock);
+        properties->metrics.timeouts++;
+        pthread_mutex_unlock(&properties->metrics_lock);
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Timeout waiting for I2C bus lock");
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_ACQUIRE, NBT_BUS_LOCK_TIMEOUT);
+    }
+    if (result != 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not lock I2C bus: %s", strerror(error));
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_ACQUIRE, IFX_UNSPECIFIED_ERROR);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Acquires bus lock, blocking until it is granted or the configured timeout expires.
+ *
+ * \param[in] self Bus lock protocol layer.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_bus_lock_acquire(ifx_protocol_t *self)
+{
+    struct nbt_bus_lock_properties *properties = (struct nbt_bus_lock_properties *) self->_properties;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Uncontended locks are taken without setting up the timer
+    bool contended = false;
+    if (flock(properties->fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        if ((errno != EWOULDBLOCK) && (errno != EINTR))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not lock I2C bus: %s", strerror(errno));
+            return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_ACQUIRE, IFX_UNSPECIFIED_ERROR);
+        }
+        contended = true;
+        ifx_status_t status = nbt_bus_lock_wait(properties, &start);
+        if (ifx_error_check(status))
+        {
+            return status;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &properties->acquired_at);
+    uint64_t wait_ns = nbt_bus_lock_elapsed_ns(&start, &properties->acquired_at);
+    pthread_mutex_lock(&properties->metrics_lock);
+    properties->metrics.acquisitions++;
+    properties->metrics.contended += contended ? 1U : 0U;
+    properties->metrics.wait_total_ns += wait_ns;
+    if (wait_ns > properties->metrics.wait_max_ns)
+    {
+        properties->metrics.wait_max_ns = wait_ns;
+    }
+    pthread_mutex_unlock(&properties->metrics_lock);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Releases bus lock and records hold time.
+ *
+ * \param[in] self Bus lock protocol layer.
+ */
+static void nbt_bus_lock_release(ifx_protocol_t *self)
+{
+    struct nbt_bus_lock_properties *properties = (struct nbt_bus_lock_properties *) self->_properties;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    flock(properties->fd, LOCK_UN);
+
+    uint64_t hold_ns = nbt_bus_lock_elapsed_ns(&properties->acquired_at, &now);
+    pthread_mutex_lock(&properties->metrics_lock);
+    properties->metrics.hold_total_ns += hold_ns;
+    if (hold_ns > properties->metrics.hold_max_ns)
+    {
+        properties->metrics.hold_max_ns = hold_ns;
+    }
+    pthread_mutex_unlock(&properties->metrics_lock);
+}
+
+/**
+ * \brief Activates underlying protocol while holding the bus lock.
+ *
+ * \param[in] self Bus lock protocol layer.
+ * \param[out] response Buffer to store activation response in.
+ * \param[out] response_len Buffer to store number of received bytes in.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_bus_lock_activate(ifx_protocol_t *self, uint8_t **response, size_t *response_len)
+{
+    ifx_status_t status = nbt_bus_lock_acquire(self);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    status = ifx_protocol_activate(self->_base, response, response_len);
+    nbt_bus_lock_release(self);
+    return status;
+}
+
+/**
+ * \brief Exchanges one APDU via the underlying protocol while holding the bus lock.
+ *
+ * \param[in] self Bus lock protocol layer.
+ * \param[in] data Data to be sent.
+ * \param[in] data_len Number of bytes in \c data.
+ * \param[out] response Buffer to store response in.
+ * \param[out] response_len Buffer to store number of received bytes in.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_bus_lock_transceive(ifx_protocol_t *self, const uint8_t *data, size_t data_len, uint8_t **response, size_t *response_len)
+{
+    ifx_status_t status = nbt_bus_lock_acquire(self);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    status = ifx_protocol_transceive(self->_base, data, data_len, response, response_len);
+    nbt_bus_lock_release(self);
+    return status;
+}
+
+/**
+ * \brief Frees layer state and logs lock statistics.
+ *
+ * \param[in] self Bus lock protocol layer.
+ */
+static void nbt_bus_lock_destroy(ifx_protocol_t *self)
+{
+    struct nbt_bus_lock_properties *properties = (struct nbt_bus_lock_properties *) self->_properties;
+    if (properties == NULL)
+    {
+        return;
+    }
+    const struct nbt_bus_lock_metrics *metrics = &properties->metrics;
+    if (metrics->acquisitions > 0U)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_DEBUG,
+                       "%llu acquisitions (%llu contended, %llu timeouts), wait avg/max %llu/%llu us, hold avg/max %llu/%llu us",
+                       (unsigned long long) metrics->acquisitions, (unsigned long long) metrics->contended, (unsigned long long) metrics->timeouts,
+                       (unsigned long long) (metrics->wait_total_ns / metrics->acquisitions / 1000U), (unsigned long long) (metrics->wait_max_ns / 1000U),
+                       (unsigned long long) (metrics->hold_total_ns / metrics->acquisitions / 1000U), (unsigned long long) (metrics->hold_max_ns / 1000U));
+    }
+    close(properties->fd);
+    pthread_mutex_destroy(&properties->metrics_lock);
+    free(properties);
+    self->_properties = NULL;
+}
+
+/**
+ * \brief Initializes bus lock protocol layer on top of an already initialized protocol stack.
+ *
+ * \details Destroying this layer with ifx_protocol_destroy() also destroys the underlying stack. Installs a handler for
+ * \c NBT_BUS_LOCK_TIMEOUT_SIGNAL unless the application already handles it (such a handler must be installed without
+ * \c SA_RESTART).
+ *
+ * \param[in] self Protocol object to be initialized.
+ * \param[in] base Underlying protocol (e.g. GP T=1').
+ * \param[in] lock_path File to be locked (typically the I2C character device, e.g. \c "/dev/i2c-1").
+ * \param[in] timeout_ms Maximum time to wait for the lock (0 for \c NBT_BUS_LOCK_DEFAULT_TIMEOUT_MS).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_bus_lock_initialize(ifx_protocol_t *self, ifx_protocol_t *base, const char *lock_path, uint32_t timeout_ms)
+{
+    if ((self == NULL) || (base == NULL) || (lock_path == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_INITIALIZE, IFX_ILLEGAL_ARGUMENT);
+    }
+    struct nbt_bus_lock_properties *properties = (struct nbt_bus_lock_properties *) calloc(1U, sizeof(struct nbt_bus_lock_properties));
+    if (properties == NULL)
+    {
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_INITIALIZE, IFX_OUT_OF_MEMORY);
+    }
+
+    // Separate open file description, so that flock() does not interfere with the I2C driver's descriptor
+    properties->fd = open(lock_path, O_RDONLY | O_CLOEXEC);
+    if (properties->fd == -1)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not open bus lock file %s: %s", lock_path, strerror(errno));
+        free(properties);
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_INITIALIZE, IFX_UNSPECIFIED_ERROR);
+    }
+    if (pthread_mutex_init(&properties->metrics_lock, NULL) != 0)
+    {
+        close(properties->fd);
+        free(properties);
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_INITIALIZE, IFX_UNSPECIFIED_ERROR);
+    }
+    properties->timeout_ns = (uint64_t) ((timeout_ms == 0U) ? NBT_BUS_LOCK_DEFAULT_TIMEOUT_MS : timeout_ms) * 1000000U;
+
+    // Without SA_RESTART, so that the wait timer interrupts flock() (an application handler is kept)
+    struct sigaction action;
+    if ((sigaction(NBT_BUS_LOCK_TIMEOUT_SIGNAL, NULL, &action) == 0) && ((action.sa_handler == SIG_DFL) || (action.sa_handler == SIG_IGN)))
+    {
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = nbt_bus_lock_timeout_handler;
+        sigemptyset(&action.sa_mask);
+        sigaction(NBT_BUS_LOCK_TIMEOUT_SIGNAL, &action, NULL);
+    }
+
+    ifx_status_t status = ifx_protocol_layer_initialize(self);
+    if (ifx_error_check(status))
+    {
+        pthread_mutex_destroy(&properties->metrics_lock);
+        close(properties->fd);
+        free(properties);
+        return status;
+    }
+    self->_layer_id = NBT_BUS_LOCK_PROTOCOL_LAYER_ID;
+    self->_base = base;
+    self->_activate = nbt_bus_lock_activate;
+    self->_transceive = nbt_bus_lock_transceive;
+    self->_destructor = nbt_bus_lock_destroy;
+    self->_properties = properties;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Returns snapshot of the bus lock statistics.
+ *
+ * \param[in] self Bus lock protocol layer.
+ * \param[out] metrics Current statistics.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_bus_lock_get_metrics(const ifx_protocol_t *self, struct nbt_bus_lock_metrics *metrics)
+{
+    if ((self == NULL) || (metrics == NULL) || (self->_layer_id != NBT_BUS_LOCK_PROTOCOL_LAYER_ID) || (self->_properties == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_BUS_LOCK, NBT_BUS_LOCK_GET_METRICS, IFX_ILLEGAL_ARGUMENT);
+    }
+    struct nbt_bus_lock_properties *properties = (struct nbt_bus_lock_properties *) self->_properties;
+    pthread_mutex_lock(&properties->metrics_lock);
+    *metrics = properties->metrics;
+    pthread_mutex_unlock(&properties->metrics_lock);
+    return IFX_SUCCESS;
+}
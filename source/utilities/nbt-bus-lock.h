@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-bus-lock.h
+ * \brief Protocol layer arbitrating a shared I2C bus between processes.
+ *
+ * \details The layer is stacked on top of the GP T=1' protocol and takes an advisory \c flock() on a lock file (by
+ * default the I2C character device itself) for the duration of a single APDU exchange. Other daemons sharing the bus
+ * cooperate by locking the same file around their own transfers. Holding the lock per APDU rather than per process keeps
+ * other devices from starving, while T=1' frames of one APDU are never interleaved with foreign traffic.
+ *
+ * A contended lock is waited for in a blocking \c flock(), so the kernel wakes the waiter as soon as the bus is released
+ * instead of leaving it to poll against processes that re-lock right away. The timeout is enforced by a per-thread timer
+ * sending \c NBT_BUS_LOCK_TIMEOUT_SIGNAL, which must not be blocked in threads exchanging APDUs.
+ */
+#ifndef NBT_BUS_LOCK_H
+#define NBT_BUS_LOCK_H
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Identifier for the bus lock layer used in error codes.
+ */
+#define LIB_NBT_BUS_LOCK 0x63U
+
+/**
+ * \brief IFX protocol layer ID of the bus lock layer.
+ */
+#define NBT_BUS_LOCK_PROTOCOL_LAYER_ID 0x63U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_bus_lock_initialize().
+ */
+#define NBT_BUS_LOCK_INITIALIZE 0x01U
+
+/**
+ * \brief IFX error encoding function identifier for acquiring the bus lock.
+ */
+#define NBT_BUS_LOCK_ACQUIRE 0x02U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_bus_lock_get_metrics().
+ */
+#define NBT_BUS_LOCK_GET_METRICS 0x03U
+
+/**
+ * \brief Error reason if the bus lock could not be acquired within the configured timeout.
+ */
+#define NBT_BUS_LOCK_TIMEOUT 0x20U
+
+/**
+ * \brief Default time to wait for the bus lock in milliseconds.
+ */
+#define NBT_BUS_LOCK_DEFAULT_TIMEOUT_MS 1000U
+
+/**
+ * \brief Signal interrupting a blocked \c flock() once the lock timeout expired.
+ */
+#define NBT_BUS_LOCK_TIMEOUT_SIGNAL SIGALRM
+
+/** \struct nbt_bus_lock_metrics
+ * \brief Wait and hold time statistics of the bus lock.
+ */
+struct nbt_bus_lock_metrics
+{
+    /**
+     * \brief Number of successful lock acquisitions.
+     */
+    uint64_t acquisitions;
+
+    /**
+     * \brief Number of acquisitions that found the bus locked by another process.
+     */
+    uint64_t contended;
+
+    /**
+     * \brief Number of acquisitions that timed out.
+     */
+    uint64_t timeouts;
+
+    /**
+     * \brief Accumulated time spent waiting for the lock in nanoseconds.
+     */
+    uint64_t wait_total_ns;
+
+    /**
+     * \brief Longest single wait for the lock in nanoseconds.
+     */
+    uint64_t wait_max_ns;
+
+    /**
+     * \brief Accumulated time the lock was held in nanoseconds.
+     */
+    uint64_t hold_total_ns;
+
+    /**
+     * \brief Longest single lock hold in nanoseconds.
+     */
+    uint64_t hold_max_ns;
+};
+
+/**
+ * \brief Initializes bus lock protocol layer on top of an already initialized protocol stack.
+ *
+ * \details Destroying this layer with ifx_protocol_destroy() also destroys the underlying stack. Installs a handler for
+ * \c NBT_BUS_LOCK_TIMEOUT_SIGNAL unless the application already handles it (such a handler must be installed without
+ * \c SA_RESTART).
+ *
+ * \param[in] self Protocol object to be initialized.
+ * \param[in] base Underlying protocol (e.g. GP T=1').
+ * \param[in] lock_path File to be locked (typically the I2C character device, e.g. \c "/dev/i2c-1").
+ * \param[in] timeout_ms Maximum time to wait for the lock (0 for \c NBT_BUS_LOCK_DEFAULT_TIMEOUT_MS).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_bus_lock_initialize(ifx_protocol_t *self, ifx_protocol_t *base, const char *lock_path, uint32_t timeout_ms);
+
+/**
+ * \brief Returns snapshot of the bus lock statistics.
+ *
+ * \param[in] self Bus lock protocol layer.
+ * \param[out] metrics Current statistics.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_bus_lock_get_metrics(const ifx_protocol_t *self, struct nbt_bus_lock_metrics *metrics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NBT_BUS_LOCK_H
@@ -0,0 +1,375 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-channel-plan.c
+ * \brief Channel and band planner for the advertised WiFi P2P carrier.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-logger.h"
+
+#include "nbt-channel-plan.h"
+#include "nbt-handover.h"
+
+/**
+ * \brief String used as source information for logging.
+ */
+#define LOG_TAG "NBT channel plan"
+
+/**
+ * \brief Number of 20 MHz channels (5 MHz steps) a 2.4 GHz network overlaps to each side (plus one).
+ */
+#define NBT_CHANNEL_PLAN_2_4GHZ_OVERLAP 5U
+
+/**
+ * \brief Signal level mapped to weight 1 (weaker networks are ignored).
+ */
+#define NBT_CHANNEL_PLAN_NOISE_FLOOR_DBM (-100)
+
+/**
+ * \brief Signal level at which weights are capped.
+ */
+#define NBT_CHANNEL_PLAN_MAX_SIGNAL_DBM (-10)
+
+/**
+ * \brief Penalty for 2.4 GHz candidates (a co-channel network at -80 dBm) for Bluetooth and other non-WiFi users.
+ */
+#define NBT_CHANNEL_PLAN_2_4GHZ_PENALTY ((UINT64_C(1) << ((-80 - NBT_CHANNEL_PLAN_NOISE_FLOOR_DBM) / 3)) * NBT_CHANNEL_PLAN_2_4GHZ_OVERLAP)
+
+/**
+ * \brief Penalty for 20 MHz 5 GHz candidates in HT40 mode (a co-channel network at -85 dBm), so that a 40 MHz pair with
+ * only faint networks still wins.
+ */
+#define NBT_CHANNEL_PLAN_20MHZ_PENALTY ((UINT64_C(1) << ((-85 - NBT_CHANNEL_PLAN_NOISE_FLOOR_DBM) / 3)) * NBT_CHANNEL_PLAN_2_4GHZ_OVERLAP)
+
+/**
+ * \brief IEEE 802.11 global operating class for 2.4 GHz channels 1-13 (20 MHz).
+ */
+#define OPERATING_CLASS_2_4GHZ 81U
+
+/**
+ * \brief IEEE 802.11 global operating class for 5 GHz channels 36-48 (20 MHz).
+ */
+#define OPERATING_CLASS_5GHZ_20MHZ 115U
+
+/**
+ * \brief IEEE 802.11 global operating class for 5 GHz channels 36 and 44 with secondary channel above (40 MHz).
+ */
+#define OPERATING_CLASS_5GHZ_40MHZ_PLUS 116U
+
+/** \struct nbt_channel_candidate
+ * \brief Channel the group owner may operate on.
+ */
+struct nbt_channel_candidate
+{
+    /**
+     * \brief (Primary) channel number.
+     */
+    uint16_t channel;
+
+    /**
+     * \brief Secondary channel number of 40 MHz channels (0 for 20 MHz).
+     */
+    uint16_t secondary;
+
+    /**
+     * \brief IEEE 802.11 global operating class.
+     */
+    uint8_t operating_class;
+
+    /**
+     * \brief WSC RF band.
+     */
+    uint8_t rf_bands;
+};
+
+/**
+ * \brief 5 GHz candidates as 40 MHz pairs (preferred on ties).
+ */
+static const struct nbt_channel_candidate CANDIDATES_5GHZ_40MHZ[] = {{36U, 40U, OPERATING_CLASS_5GHZ_40MHZ_PLUS, NBT_HANDOVER_RF_BAND_5GHZ},
+                                                                      {44U, 48U, OPERATING_CLASS_5GHZ_40MHZ_PLUS, NBT_HANDOVER_RF_BAND_5GHZ}};
+
+/**
+ * \brief 5 GHz candidates as 20 MHz channels (preferred on ties).
+ */
+static const struct nbt_channel_candidate CANDIDATES_5GHZ_20MHZ[] = {{36U, 0U, OPERATING_CLASS_5GHZ_20MHZ, NBT_HANDOVER_RF_BAND_5GHZ},
+                                                                      {40U, 0U, OPERATING_CLASS_5GHZ_20MHZ, NBT_HANDOVER_RF_BAND_5GHZ},
+                                                                      {44U, 0U, OPERATING_CLASS_5GHZ_20MHZ, NBT_HANDOVER_RF_BAND_5GHZ},
+                                                                      {48U, 0U, OPERATING_CLASS_5GHZ_20MHZ, NBT_HANDOVER_RF_BAND_5GHZ}};
+
+/**
+ * \brief Non-overlapping 2.4 GHz candidates.
+ */
+static const struct nbt_channel_candidate CANDIDATES_2_4GHZ[] = {{1U, 0U, OPERATING_CLASS_2_4GHZ, NBT_HANDOVER_RF_BAND_2_4GHZ},
+                                                                  {6U, 0U, OPERATING_CLASS_2_4GHZ, NBT_HANDOVER_RF_BAND_2_4GHZ},
+                                                                  {11U, 0U, OPERATING_CLASS_2_4GHZ, NBT_HANDOVER_RF_BAND_2_4GHZ}};
+
+/**
+ * \brief Initializes empty channel planner.
+ *
+ * \param[in] self Channel planner.
+ * \param[in] allow_5ghz \c true if 5 GHz channels may be chosen.
+ * \param[in] ht40 \c true if 5 GHz channels are used as 40 MHz pairs.
+ */
+void nbt_channel_planner_initialize(struct nbt_channel_planner *self, bool allow_5ghz, bool ht40)
+{
+    memset(self, 0, sizeof(struct nbt_channel_planner));
+    self->allow_5ghz = allow_5ghz;
+    self->ht40 = ht40;
+}
+
+/**
+ * \brief Accounts for a single network seen in a scan.
+ *
+ * \param[in] self Channel planner.
+ * \param[in] frequency_mhz Center frequency of the network in MHz.
+ * \param[in] signal_dbm Received signal level in dBm.
+ */
+void nbt_channel_planner_add_network(struct nbt_channel_planner *self, uint32_t frequency_mhz, int32_t signal_dbm)
+{
+    if (signal_dbm < NBT_CHANNEL_PLAN_NOISE_FLOOR_DBM)
+    {
+        return;
+    }
+    if (signal_dbm > NBT_CHANNEL_PLAN_MAX_SIGNAL_DBM)
+    {
+        signal_dbm = NBT_CHANNEL_PLAN_MAX_SIGNAL_DBM;
+    }
+
+    // Linear power weight, doubling every 3 dB
+    uint64_t weight = UINT64_C(1) << ((uint32_t) (signal_dbm - NBT_CHANNEL_PLAN_NOISE_FLOOR_DBM) / 3U);
+    if ((frequency_mhz >= 2412U) && (frequency_mhz <= 2484U))
+    {
+        uint32_t channel = (frequency_mhz == 2484U) ? 14U : ((frequency_mhz - 2407U) / 5U);
+        for (uint32_t neighbour = 1U; neighbour <= 14U; neighbour++)
+        {
+            uint32_t distance = (neighbour > channel) ? (neighbour - channel) : (channel - neighbour);
+            if (distance < NBT_CHANNEL_PLAN_2_4GHZ_OVERLAP)
+            {
+                self->interference[neighbour] += weight * (NBT_CHANNEL_PLAN_2_4GHZ_OVERLAP - distance);
+            }
+        }
+    }
+    else if ((frequency_mhz > 5000U) && (frequency_mhz <= (5000U + (5U * NBT_CHANNEL_PLAN_MAX_CHANNEL))))
+    {
+        self->interference[(frequency_mhz - 5000U) / 5U] += weight * NBT_CHANNEL_PLAN_2_4GHZ_OVERLAP;
+    }
+    else
+    {
+        return;
+    }
+    self->networks++;
+}
+
+/**
+ * \brief Accounts for all networks in scan results of \c "wpa_cli scan_results" or \c "iw dev <interface> scan" format.
+ *
+ * \param[in] self Channel planner.
+ * \param[in] scan_results Stream of scan results (e.g. a recorded fixture).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_channel_planner_read_scan_results(struct nbt_channel_planner *self, FILE *scan_results)
+{
+    if ((self == NULL) || (scan_results == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_CHANNEL_PLAN, NBT_CHANNEL_PLAN_SCAN, IFX_ILLEGAL_ARGUMENT);
+    }
+
+    // wpa_cli: one line per network "bssid / frequency / signal level / flags / ssid" (header line does not match)
+    // iw: "BSS <bssid>" line per network followed by indented attributes, including "freq: <MHz>" and "signal: <dBm>"
+    char line[512];
+    unsigned int bss_frequency_mhz = 0U;
+    int bss_signal_dbm = 0;
+    bool bss_signal = false;
+    while (fgets(line, sizeof(line), scan_results) != NULL)
+    {
+        const char *attribute = line + strspn(line, " \t");
+        char bssid[18];
+        unsigned int frequency_mhz;
+        int signal_dbm;
+        if (strncmp(line, "BSS ", 4U) == 0)
+        {
+            if ((bss_frequency_mhz != 0U) && bss_signal)
+            {
+                nbt_channel_planner_add_network(self, bss_frequency_mhz, bss_signal_dbm);
+            }
+            bss_frequency_mhz = 0U;
+            bss_signal = false;
+        }
+        else if (attribute != line)
+        {
+            if (sscanf(attribute, "freq: %u", &frequency_mhz) == 1)
+            {
+                bss_frequency_mhz = frequency_mhz;
+            }
+            else if (sscanf(attribute, "signal: %d", &signal_dbm) == 1)
+            {
+                bss_signal_dbm = signal_dbm;
+                bss_signal = true;
+            }
+        }
+        else if (sscanf(line, "%17s %u %d", bssid, &frequency_mhz, &signal_dbm) == 3)
+        {
+            nbt_channel_planner_add_network(self, frequency_mhz, signal_dbm);
+        }
+    }
+    if ((bss_frequency_mhz != 0U) && bss_signal)
+    {
+        nbt_channel_planner_add_network(self, bss_frequency_mhz, bss_signal_dbm);
+    }
+    if (ferror(scan_results))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not read scan results");
+        return IFX_ERROR(LIB_NBT_CHANNEL_PLAN, NBT_CHANNEL_PLAN_SCAN, IFX_UNSPECIFIED_ERROR);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Accounts for the latest scan results of \c NBT_CHANNEL_PLAN_SCAN_INTERFACE as reported by \c wpa_cli.
+ *
+ * \param[in] self Channel planner.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_channel_planner_scan(struct nbt_channel_planner *self)
+{
+    FILE *scan_results = popen("wpa_cli -i " NBT_CHANNEL_PLAN_SCAN_INTERFACE " scan_results", "r");
+    if (scan_results == NULL)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not run wpa_cli");
+        return IFX_ERROR(LIB_NBT_CHANNEL_PLAN, NBT_CHANNEL_PLAN_SCAN, IFX_UNSPECIFIED_ERROR);
+    }
+    ifx_status_t status = nbt_channel_planner_read_scan_results(self, scan_results);
+    if ((pclose(scan_results) != 0) && !ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not get scan results of " NBT_CHANNEL_PLAN_SCAN_INTERFACE);
+        status = IFX_ERROR(LIB_NBT_CHANNEL_PLAN, NBT_CHANNEL_PLAN_SCAN, IFX_UNSPECIFIED_ERROR);
+    }
+    return status;
+}
+
+/**
+ * \brief Chooses candidate with the lowest interference from a candidate list.
+ *
+ * \param[in] self Channel planner.
+ * \param[in] candidates Candidate list.
+ * \param[in] count Number of entries in \c candidates.
+ * \param[in] penalty Cost added to every candidate of the list.
+ * \param[in,out] plan Current best channel (replaced only by strictly better candidates).
+ */
+static void nbt_channel_planner_choose_from(const struct nbt_channel_planner *self, const struct nbt_channel_candidate *candidates, size_t count,
+                                            uint64_t penalty, struct nbt_channel_plan *plan)
+{
+    for (size_t i = 0U; i < count; i++)
+    {
+        uint64_t cost = self->interference[candidates[i].channel] + penalty;
+        if (candidates[i].secondary != 0U)
+        {
+            cost += self->interference[candidates[i].secondary];
+        }
+        if ((plan->channel == 0U) || (cost < plan->cost))
+        {
+            plan->channel = candidates[i].channel;
+            plan->rf_bands = candidates[i].rf_bands;
+            plan->operating_class = candidates[i].operating_class;
+            plan->ht40 = (candidates[i].secondary != 0U);
+            plan->cost = cost;
+        }
+    }
+}
+
+/**
+ * \brief Chooses channel with the lowest interference.
+ *
+ * \param[in] self Channel planner.
+ * \param[out] plan Chosen channel.
+ */
+void nbt_channel_planner_choose(const struct nbt_channel_planner *self, struct nbt_channel_plan *plan)
+{
+    memset(plan, 0, sizeof(struct nbt_channel_plan));
+    if (self->allow_5ghz)
+    {
+        // With p2p_go_ht40 the group owner still runs on 20 MHz channels, so a quiet one beats a busy pair
+        if (self->ht40)
+        {
+            nbt_channel_planner_choose_from(self, CANDIDATES_5GHZ_40MHZ, sizeof(CANDIDATES_5GHZ_40MHZ) / sizeof(CANDIDATES_5GHZ_40MHZ[0]), 0U, plan);
+        }
+        nbt_channel_planner_choose_from(self, CANDIDATES_5GHZ_20MHZ, sizeof(CANDIDATES_5GHZ_20MHZ) / sizeof(CANDIDATES_5GHZ_20MHZ[0]),
+                                        self->ht40 ? NBT_CHANNEL_PLAN_20MHZ_PENALTY : 0U, plan);
+    }
+    nbt_channel_planner_choose_from(self, CANDIDATES_2_4GHZ, sizeof(CANDIDATES_2_4GHZ) / sizeof(CANDIDATES_2_4GHZ[0]),
+                                    self->allow_5ghz ? NBT_CHANNEL_PLAN_2_4GHZ_PENALTY : 0U, plan);
+    ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "Chose channel %u (operating class %u%s) from %u networks, cost %llu",
+                   plan->channel, plan->operating_class, plan->ht40 ? ", 40 MHz" : "", (unsigned int) self->networks,
+                   (unsigned long long) plan->cost);
+}
+
+/**
+ * \brief Runs a single \c wpa_cli command for \c NBT_CHANNEL_PLAN_P2P_INTERFACE and checks for an \c OK reply.
+ *
+ * \param[in] command Command and arguments.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_channel_plan_wpa_cli(const char *command)
+{
+    char invocation[128];
+    snprintf(invocation, sizeof(invocation), "wpa_cli -i " NBT_CHANNEL_PLAN_P2P_INTERFACE " %s", command);
+    FILE *output = popen(invocation, "r");
+    if (output == NULL)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not run wpa_cli");
+        return IFX_ERROR(LIB_NBT_CHANNEL_PLAN, NBT_CHANNEL_PLAN_APPLY_GO, IFX_UNSPECIFIED_ERROR);
+    }
+    char reply[64] = {0};
+    bool ok = (fgets(reply, sizeof(reply), output) != NULL) && (strncmp(reply, "OK", 2U) == 0);
+    if ((pclose(output) != 0) || !ok)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "wpa_cli %s failed", command);
+        return IFX_ERROR(LIB_NBT_CHANNEL_PLAN, NBT_CHANNEL_PLAN_APPLY_GO, IFX_UNSPECIFIED_ERROR);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Configures (and persists) operating channel of the P2P group owner in \c wpa_supplicant.
+ *
+ * \details Sets \c p2p_oper_reg_class, \c p2p_oper_channel and \c p2p_go_ht40 for \c NBT_CHANNEL_PLAN_P2P_INTERFACE
+ * and saves the configuration (requires \c update_config=1).
+ *
+ * \param[in] plan Channel to be used.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_channel_plan_apply_go(const struct nbt_channel_plan *plan)
+{
+    if ((plan == NULL) || (plan->channel == 0U))
+    {
+        return IFX_ERROR(LIB_NBT_CHANNEL_PLAN, NBT_CHANNEL_PLAN_APPLY_GO, IFX_ILLEGAL_ARGUMENT);
+    }
+    char command[64];
+    snprintf(command, sizeof(command), "set p2p_oper_reg_class %u", plan->operating_class);
+    ifx_status_t status = nbt_channel_plan_wpa_cli(command);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    snprintf(command, sizeof(command), "set p2p_oper_channel %u", plan->channel);
+    status = nbt_channel_plan_wpa_cli(command);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    snprintf(command, sizeof(command), "set p2p_go_ht40 %u", plan->ht40 ? 1U : 0U);
+    status = nbt_channel_plan_wpa_cli(command);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    return nbt_channel_plan_wpa_cli("save_config");
+}
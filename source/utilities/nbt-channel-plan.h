@@ -0,0 +1,176 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-channel-plan.h
+ * \brief Channel and band planner for the advertised WiFi P2P carrier.
+ *
+ * \details Networks from a WiFi scan are accumulated as interference per 20 MHz channel. Signal levels are weighted
+ * linearly (doubling every 3 dB) and 2.4 GHz networks also count on overlapping neighbour channels. The candidate with
+ * the lowest interference is chosen from the non-overlapping 2.4 GHz channels 1, 6 and 11 and, if enabled, the
+ * non-DFS 5 GHz channels 36-48 (when \c p2p_go_ht40 is used, 40 MHz pairs are preferred over single 20 MHz channels by a
+ * small penalty). 2.4 GHz candidates carry an additional penalty accounting for non-WiFi users of the band.
+ *
+ * Scan results are read in the \c "wpa_cli scan_results" or \c "iw dev <interface> scan" format, so recorded outputs
+ * can be replayed for testing (see \c source/test/fixtures/channel-plan).
+ */
+#ifndef NBT_CHANNEL_PLAN_H
+#define NBT_CHANNEL_PLAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "infineon/ifx-error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Identifier for the channel planner used in error codes.
+ */
+#define LIB_NBT_CHANNEL_PLAN 0x66U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_channel_planner_read_scan_results() and nbt_channel_planner_scan().
+ */
+#define NBT_CHANNEL_PLAN_SCAN 0x01U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_channel_plan_apply_go().
+ */
+#define NBT_CHANNEL_PLAN_APPLY_GO 0x02U
+
+/**
+ * \brief Highest 20 MHz channel number tracked by the planner.
+ */
+#define NBT_CHANNEL_PLAN_MAX_CHANNEL 196U
+
+/**
+ * \brief WiFi station interface used for live scans.
+ */
+#define NBT_CHANNEL_PLAN_SCAN_INTERFACE "wlan0"
+
+/**
+ * \brief WiFi P2P device interface whose group owner configuration is updated.
+ */
+#define NBT_CHANNEL_PLAN_P2P_INTERFACE "p2p-dev-wlan0"
+
+/** \struct nbt_channel_planner
+ * \brief Accumulated scan results and planning options.
+ */
+struct nbt_channel_planner
+{
+    /**
+     * \brief Weighted interference per 20 MHz channel number.
+     */
+    uint64_t interference[NBT_CHANNEL_PLAN_MAX_CHANNEL + 1U];
+
+    /**
+     * \brief Number of networks taken into account.
+     */
+    size_t networks;
+
+    /**
+     * \brief \c true if 5 GHz channels may be chosen.
+     */
+    bool allow_5ghz;
+
+    /**
+     * \brief \c true if 5 GHz channels are used as 40 MHz pairs (\c p2p_go_ht40).
+     */
+    bool ht40;
+};
+
+/** \struct nbt_channel_plan
+ * \brief Chosen channel of the P2P group owner.
+ */
+struct nbt_channel_plan
+{
+    /**
+     * \brief (Primary) channel number.
+     */
+    uint16_t channel;
+
+    /**
+     * \brief WSC RF band (\c NBT_HANDOVER_RF_BAND_2_4GHZ or \c NBT_HANDOVER_RF_BAND_5GHZ).
+     */
+    uint8_t rf_bands;
+
+    /**
+     * \brief IEEE 802.11 global operating class of channel (and width).
+     */
+    uint8_t operating_class;
+
+    /**
+     * \brief \c true if the group owner shall use a 40 MHz channel.
+     */
+    bool ht40;
+
+    /**
+     * \brief Interference score of the chosen channel (lower is better).
+     */
+    uint64_t cost;
+};
+
+/**
+ * \brief Initializes empty channel planner.
+ *
+ * \param[in] self Channel planner.
+ * \param[in] allow_5ghz \c true if 5 GHz channels may be chosen.
+ * \param[in] ht40 \c true if 5 GHz channels are used as 40 MHz pairs.
+ */
+void nbt_channel_planner_initialize(struct nbt_channel_planner *self, bool allow_5ghz, bool ht40);
+
+/**
+ * \brief Accounts for a single network seen in a scan.
+ *
+ * \param[in] self Channel planner.
+ * \param[in] frequency_mhz Center frequency of the network in MHz.
+ * \param[in] signal_dbm Received signal level in dBm.
+ */
+void nbt_channel_planner_add_network(struct nbt_channel_planner *self, uint32_t frequency_mhz, int32_t signal_dbm);
+
+/**
+ * \brief Accounts for all networks in scan results of \c "wpa_cli scan_results" or \c "iw dev <interface> scan" format.
+ *
+ * \param[in] self Channel planner.
+ * \param[in] scan_results Stream of scan results (e.g. a recorded fixture).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_channel_planner_read_scan_results(struct nbt_channel_planner *self, FILE *scan_results);
+
+/**
+ * \brief Accounts for the latest scan results of \c NBT_CHANNEL_PLAN_SCAN_INTERFACE as reported by \c wpa_cli.
+ *
+ * \param[in] self Channel planner.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_channel_planner_scan(struct nbt_channel_planner *self);
+
+/**
+ * \brief Chooses channel with the lowest interference.
+ *
+ * \param[in] self Channel planner.
+ * \param[out] plan Chosen channel.
+ */
+void nbt_channel_planner_choose(const struct nbt_channel_planner *self, struct nbt_channel_plan *plan);
+
+/**
+ * \brief Configures (and persists) operating channel of the P2P group owner in \c wpa_supplicant.
+ *
+ * \details Sets \c p2p_oper_reg_class, \c p2p_oper_channel and \c p2p_go_ht40 for \c NBT_CHANNEL_PLAN_P2P_INTERFACE
+ * and saves the configuration (requires \c update_config=1).
+ *
+ * \param[in] plan Channel to be used.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_channel_plan_apply_go(const struct nbt_channel_plan *plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NBT_CHANNEL_PLAN_H
@@ -0,0 +1,587 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-handover.c
+ * \brief In-place patching of the WiFi P2P connection handover NDEF message and per-session credential rotation.
+ */
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+#include <time.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-logger.h"
+#include "infineon/nbt-cmd.h"
+
+#include "nbt-handover.h"
+#include "nbt-utilities.h"
+
+/**
+ * \brief String used as source information for logging.
+ */
+#define LOG_TAG "NBT handover"
+
+/**
+ * \brief NDEF record header flags.
+ */
+#define NDEF_FLAG_SR  0x10U
+#define NDEF_FLAG_IL  0x08U
+#define NDEF_TNF_MASK 0x07U
+#define NDEF_TNF_MIME 0x02U
+
+/**
+ * \brief Wi-Fi Simple Configuration attribute types.
+ */
+#define WSC_ATTRIBUTE_AP_CHANNEL   0x1001U
+#define WSC_ATTRIBUTE_MAC_ADDRESS  0x1020U
+#define WSC_ATTRIBUTE_OOB_PASSWORD 0x102CU
+#define WSC_ATTRIBUTE_RF_BANDS     0x103CU
+#define WSC_ATTRIBUTE_SSID         0x1045U
+
+/**
+ * \brief MIME type of the Wi-Fi Simple Configuration carrier record.
+ */
+static const char WSC_MIME_TYPE[] = "application/vnd.wfa.wsc";
+
+/**
+ * \brief Characters used for the random part of the SSID and for the passphrase.
+ */
+static const char SSID_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+
+/**
+ * \brief Maximum number of \c wpa_supplicant networks checked for stale group owner networks.
+ */
+#define MAX_GO_NETWORKS 32U
+
+/**
+ * \brief Walks WSC attributes of carrier configuration payload and stores offsets of mutable fields.
+ *
+ * \param[in] message NDEF file contents.
+ * \param[in] start Offset of first attribute.
+ * \param[in] end Offset after last attribute.
+ * \param[out] index Offset index.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_handover_index_attributes(const uint8_t *message, size_t start, size_t end, struct nbt_handover_index *index)
+{
+    size_t position = start;
+    while ((position + 4U) <= end)
+    {
+        uint16_t type = (uint16_t) ((message[position] << 8) | message[position + 1U]);
+        uint16_t length = (uint16_t) ((message[position + 2U] << 8) | message[position + 3U]);
+        position += 4U;
+        if ((position + length) > end)
+        {
+            return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_INDEX_BUILD, IFX_TOO_LITTLE_DATA);
+        }
+        struct nbt_handover_field field = {.offset = (uint16_t) position, .length = length};
+        switch (type)
+        {
+        case WSC_ATTRIBUTE_AP_CHANNEL:
+            index->channel = field;
+            break;
+        case WSC_ATTRIBUTE_MAC_ADDRESS:
+            index->mac = field;
+            break;
+        case WSC_ATTRIBUTE_OOB_PASSWORD:
+            index->oob_password = field;
+            break;
+        case WSC_ATTRIBUTE_RF_BANDS:
+            index->rf_bands = field;
+            break;
+        case WSC_ATTRIBUTE_SSID:
+            index->ssid = field;
+            break;
+        default:
+            break;
+        }
+        position += length;
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Builds offset index of the mutable fields by walking the NDEF records and WSC attributes once.
+ *
+ * \param[in] message NDEF file contents (including 2 byte NLEN).
+ * \param[in] message_length Number of bytes in \c message.
+ * \param[out] index Offset index.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_index_build(const uint8_t *message, size_t message_length, struct nbt_handover_index *index)
+{
+    if ((message == NULL) || (index == NULL) || (message_length < 2U))
+    {
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_INDEX_BUILD, IFX_ILLEGAL_ARGUMENT);
+    }
+    memset(index, 0, sizeof(struct nbt_handover_index));
+    size_t end = 2U + (size_t) ((message[0] << 8) | message[1]);
+    if (end > message_length)
+    {
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_INDEX_BUILD, IFX_TOO_LITTLE_DATA);
+    }
+
+    // Walk NDEF records until the WSC carrier configuration record is found
+    size_t position = 2U;
+    while (position < end)
+    {
+        // Header: flags, type length, 1 or 4 byte payload length, optional ID length
+        uint8_t flags = message[position++];
+        size_t header_remaining = 1U + ((flags & NDEF_FLAG_SR) ? 1U : 4U) + ((flags & NDEF_FLAG_IL) ? 1U : 0U);
+        if (header_remaining > (end - position))
+        {
+            break;
+        }
+        size_t type_length = message[position++];
+        size_t payload_length = 0U;
+        if (flags & NDEF_FLAG_SR)
+        {
+            payload_length = message[position++];
+        }
+        else
+        {
+            payload_length = ((size_t) message[position] << 24) | ((size_t) message[position + 1U] << 16) | ((size_t) message[position + 2U] << 8) |
+                             message[position + 3U];
+            position += 4U;
+        }
+        size_t id_length = (flags & NDEF_FLAG_IL) ? message[position++] : 0U;
+        size_t type_offset = position;
+        if (((type_length + id_length) > (end - type_offset)) || (payload_length > (end - type_offset - type_length - id_length)))
+        {
+            break;
+        }
+        size_t payload_offset = type_offset + type_length + id_length;
+        if (((flags & NDEF_TNF_MASK) == NDEF_TNF_MIME) && (type_length == (sizeof(WSC_MIME_TYPE) - 1U)) &&
+            (memcmp(&message[type_offset], WSC_MIME_TYPE, type_length) == 0))
+        {
+            // Carrier configuration: 2 byte OOB data length followed by WSC attributes
+            if (payload_length < 2U)
+            {
+                break;
+            }
+            ifx_status_t status = nbt_handover_index_attributes(message, payload_offset + 2U, payload_offset + payload_length, index);
+            if (ifx_error_check(status))
+            {
+                return status;
+            }
+            if ((index->mac.length != NBT_HANDOVER_MAC_LENGTH) || (index->oob_password.length < NBT_HANDOVER_PUBLIC_KEY_HASH_LENGTH) ||
+                (index->ssid.length == 0U) || (index->ssid.length > NBT_HANDOVER_SSID_MAX_LENGTH))
+            {
+                ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Handover carrier record lacks mandatory attributes");
+                return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_INDEX_BUILD, IFX_PROGRAMMING_ERROR);
+            }
+            return IFX_SUCCESS;
+        }
+        position = payload_offset + payload_length;
+    }
+    ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "No WSC carrier configuration record found in handover message");
+    return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_INDEX_BUILD, IFX_PROGRAMMING_ERROR);
+}
+
+/**
+ * \brief Initializes handover state for a message that is already stored in the NDEF file.
+ *
+ * \param[in] self Handover state.
+ * \param[in] message Message buffer as written to the NDEF file (patched in place later on).
+ * \param[in] message_length Number of bytes in \c message.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_initialize(struct nbt_handover *self, uint8_t *message, size_t message_length)
+{
+    if ((self == NULL) || (message == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_INITIALIZE, IFX_ILLEGAL_ARGUMENT);
+    }
+    ifx_status_t status = nbt_handover_index_build(message, message_length, &self->index);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    self->message = message;
+    self->message_length = message_length;
+    self->rotations = 0U;
+    self->last_apply_us = 0U;
+    nbt_handover_get_credentials(self, &self->next);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Reads current field values from the message.
+ *
+ * \param[in] self Handover state.
+ * \param[out] credentials Current field values.
+ */
+void nbt_handover_get_credentials(const struct nbt_handover *self, struct nbt_handover_credentials *credentials)
+{
+    const struct nbt_handover_index *index = &self->index;
+    memset(credentials, 0, sizeof(struct nbt_handover_credentials));
+    memcpy(credentials->mac, &self->message[index->mac.offset], NBT_HANDOVER_MAC_LENGTH);
+    memcpy(credentials->public_key_hash, &self->message[index->oob_password.offset], NBT_HANDOVER_PUBLIC_KEY_HASH_LENGTH);
+    memcpy(credentials->ssid, &self->message[index->ssid.offset], index->ssid.length);
+    credentials->ssid_length = index->ssid.length;
+    if (index->channel.length == 2U)
+    {
+        credentials->channel = (uint16_t) ((self->message[index->channel.offset] << 8) | self->message[index->channel.offset + 1U]);
+    }
+    if (index->rf_bands.length == 1U)
+    {
+        credentials->rf_bands = self->message[index->rf_bands.offset];
+    }
+}
+
+/**
+ * \brief Generates fresh per-session credentials based on the current ones.
+ *
+ * \details Replaces the OOB public key hash, the random SSID characters following \c "DIRECT-" and the passphrase with
+ * random values. MAC address, channel and band are kept and may be adjusted by the caller before applying.
+ *
+ * \param[in] self Handover state.
+ * \param[out] credentials Fresh credentials.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_generate_credentials(const struct nbt_handover *self, struct nbt_handover_credentials *credentials)
+{
+    if ((self == NULL) || (credentials == NULL) || (self->message == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_GENERATE_CREDENTIALS, IFX_ILLEGAL_ARGUMENT);
+    }
+    nbt_handover_get_credentials(self, credentials);
+
+    uint8_t random[NBT_HANDOVER_PUBLIC_KEY_HASH_LENGTH + NBT_HANDOVER_SSID_RANDOM_LENGTH + NBT_HANDOVER_PASSPHRASE_LENGTH];
+    if (getrandom(random, sizeof(random), 0) != (ssize_t) sizeof(random))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not get random data for credential rotation");
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_GENERATE_CREDENTIALS, IFX_UNSPECIFIED_ERROR);
+    }
+    memcpy(credentials->public_key_hash, random, NBT_HANDOVER_PUBLIC_KEY_HASH_LENGTH);
+
+    // Wi-Fi Direct SSIDs are "DIRECT-" followed by two random characters and an optional postfix
+    if (credentials->ssid_length >= (NBT_HANDOVER_SSID_PREFIX_LENGTH + NBT_HANDOVER_SSID_RANDOM_LENGTH))
+    {
+        for (size_t i = 0U; i < NBT_HANDOVER_SSID_RANDOM_LENGTH; i++)
+        {
+            uint8_t value = random[NBT_HANDOVER_PUBLIC_KEY_HASH_LENGTH + i];
+            credentials->ssid[NBT_HANDOVER_SSID_PREFIX_LENGTH + i] = (uint8_t) SSID_ALPHABET[value % (sizeof(SSID_ALPHABET) - 1U)];
+        }
+    }
+    for (size_t i = 0U; i < NBT_HANDOVER_PASSPHRASE_LENGTH; i++)
+    {
+        uint8_t value = random[NBT_HANDOVER_PUBLIC_KEY_HASH_LENGTH + NBT_HANDOVER_SSID_RANDOM_LENGTH + i];
+        credentials->passphrase[i] = SSID_ALPHABET[value % (sizeof(SSID_ALPHABET) - 1U)];
+    }
+    credentials->passphrase[NBT_HANDOVER_PASSPHRASE_LENGTH] = '\0';
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Runs a single \c wpa_cli command for \c NBT_HANDOVER_GO_INTERFACE.
+ *
+ * \param[in] command Command and arguments (already quoted for the shell).
+ * \param[out] reply Buffer for the first line of the reply, or \c NULL to check for an \c OK reply.
+ * \param[in] reply_size Size of \c reply in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_handover_wpa_cli(const char *command, char *reply, size_t reply_size)
+{
+    char invocation[256];
+    snprintf(invocation, sizeof(invocation), "wpa_cli -i " NBT_HANDOVER_GO_INTERFACE " %s", command);
+    FILE *output = popen(invocation, "r");
+    if (output == NULL)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not run wpa_cli");
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_APPLY_GO, IFX_UNSPECIFIED_ERROR);
+    }
+    char line[64] = {0};
+    bool replied = fgets(line, sizeof(line), output) != NULL;
+    line[strcspn(line, "\r\n")] = '\0';
+    bool ok = replied && ((reply != NULL) || (strcmp(line, "OK") == 0));
+    if ((pclose(output) != 0) || !ok)
+    {
+        // Only log the command name, arguments may contain the passphrase
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "wpa_cli %.*s failed", (int) strcspn(command, " "), command);
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_APPLY_GO, IFX_UNSPECIFIED_ERROR);
+    }
+    if (reply != NULL)
+    {
+        snprintf(reply, reply_size, "%s", line);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Removes all networks marked with \c NBT_HANDOVER_GO_ID_STR (group owners of previous sessions).
+ *
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_handover_remove_go_networks(void)
+{
+    FILE *networks = popen("wpa_cli -i " NBT_HANDOVER_GO_INTERFACE " list_networks", "r");
+    if (networks == NULL)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not run wpa_cli");
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_APPLY_GO, IFX_UNSPECIFIED_ERROR);
+    }
+
+    // One line per network "network id / ssid / bssid / flags" (header line does not match)
+    unsigned int ids[MAX_GO_NETWORKS];
+    size_t count = 0U;
+    char line[256];
+    while (fgets(line, sizeof(line), networks) != NULL)
+    {
+        unsigned int id;
+        if ((count < MAX_GO_NETWORKS) && (sscanf(line, "%u\t", &id) == 1))
+        {
+            ids[count++] = id;
+        }
+    }
+    if (pclose(networks) != 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "wpa_cli list_networks failed");
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_APPLY_GO, IFX_UNSPECIFIED_ERROR);
+    }
+
+    for (size_t i = 0U; i < count; i++)
+    {
+        char command[64];
+        char id_str[64];
+        snprintf(command, sizeof(command), "get_network %u id_str", ids[i]);
+        if (ifx_error_check(nbt_handover_wpa_cli(command, id_str, sizeof(id_str))) || (strcmp(id_str, "\"" NBT_HANDOVER_GO_ID_STR "\"") != 0))
+        {
+            continue;
+        }
+        snprintf(command, sizeof(command), "remove_network %u", ids[i]);
+        ifx_status_t status = nbt_handover_wpa_cli(command, NULL, 0U);
+        if (ifx_error_check(status))
+        {
+            return status;
+        }
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Configures (and persists) the P2P group owner in \c wpa_supplicant for the given SSID and passphrase.
+ *
+ * \details Replaces the persistent group network marked with \c NBT_HANDOVER_GO_ID_STR on \c NBT_HANDOVER_GO_INTERFACE
+ * by a new one with the given credentials, restarts the group owner on it and saves the configuration (requires
+ * \c update_config=1). Runs several \c wpa_cli commands, so it must not be called from the NBT I/O thread.
+ *
+ * \param[in] credentials Credentials to be used by the group owner.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_apply_go(const struct nbt_handover_credentials *credentials)
+{
+    if ((credentials == NULL) || (credentials->ssid_length == 0U) || (credentials->ssid_length > NBT_HANDOVER_SSID_MAX_LENGTH) ||
+        (strnlen(credentials->passphrase, sizeof(credentials->passphrase)) < 8U))
+    {
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_APPLY_GO, IFX_ILLEGAL_ARGUMENT);
+    }
+
+    // Stop running group (fails if there is none) and drop the networks of previous sessions
+    char reply[64];
+    nbt_handover_wpa_cli("p2p_group_remove \\*", reply, sizeof(reply));
+    ifx_status_t status = nbt_handover_remove_go_networks();
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+
+    status = nbt_handover_wpa_cli("add_network", reply, sizeof(reply));
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    char *end = NULL;
+    errno = 0;
+    unsigned long id = strtoul(reply, &end, 10);
+    if ((errno != 0) || (end == reply) || (*end != '\0'))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "wpa_cli add_network failed");
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_APPLY_GO, IFX_UNSPECIFIED_ERROR);
+    }
+
+    // SSID is passed hex encoded, passphrase and id_str only consist of alphanumeric characters
+    char command[128];
+    int length = snprintf(command, sizeof(command), "set_network %lu ssid ", id);
+    for (size_t i = 0U; i < credentials->ssid_length; i++)
+    {
+        length += snprintf(&command[length], sizeof(command) - (size_t) length, "%02x", credentials->ssid[i]);
+    }
+    status = nbt_handover_wpa_cli(command, NULL, 0U);
+    if (!ifx_error_check(status))
+    {
+        snprintf(command, sizeof(command), "set_network %lu psk '\"%s\"'", id, credentials->passphrase);
+        status = nbt_handover_wpa_cli(command, NULL, 0U);
+    }
+    if (!ifx_error_check(status))
+    {
+        snprintf(command, sizeof(command), "set_network %lu id_str '\"" NBT_HANDOVER_GO_ID_STR "\"'", id);
+        status = nbt_handover_wpa_cli(command, NULL, 0U);
+    }
+    if (!ifx_error_check(status))
+    {
+        // Persistent P2P group owner (mode 3, disabled 2)
+        snprintf(command, sizeof(command), "set_network %lu mode 3", id);
+        status = nbt_handover_wpa_cli(command, NULL, 0U);
+    }
+    if (!ifx_error_check(status))
+    {
+        snprintf(command, sizeof(command), "set_network %lu disabled 2", id);
+        status = nbt_handover_wpa_cli(command, NULL, 0U);
+    }
+    if (!ifx_error_check(status))
+    {
+        // Start group owner on the advertised channel (otherwise wpa_supplicant chooses)
+        length = snprintf(command, sizeof(command), "p2p_group_add persistent=%lu", id);
+        if ((credentials->channel != 0U) && (credentials->rf_bands == NBT_HANDOVER_RF_BAND_5GHZ))
+        {
+            snprintf(&command[length], sizeof(command) - (size_t) length, " freq=%u", 5000U + (5U * credentials->channel));
+        }
+        else if (credentials->channel != 0U)
+        {
+            snprintf(&command[length], sizeof(command) - (size_t) length, " freq=%u", 2407U + (5U * credentials->channel));
+        }
+        status = nbt_handover_wpa_cli(command, NULL, 0U);
+    }
+    if (ifx_error_check(status))
+    {
+        snprintf(command, sizeof(command), "remove_network %lu", id);
+        nbt_handover_wpa_cli(command, NULL, 0U);
+        return status;
+    }
+    return nbt_handover_wpa_cli("save_config", NULL, 0U);
+}
+
+/**
+ * \brief Patches credentials into a copy of the message without communicating with the NBT.
+ *
+ * \param[in] self Handover state providing the field index.
+ * \param[in] credentials Credentials to be patched (SSID length must match the encoded SSID).
+ * \param[in,out] message Buffer of nbt_handover.message_length bytes with the same layout as nbt_handover.message.
+ */
+void nbt_handover_patch(const struct nbt_handover *self, const struct nbt_handover_credentials *credentials, uint8_t *message)
+{
+    const struct nbt_handover_index *index = &self->index;
+    memcpy(&message[index->mac.offset], credentials->mac, NBT_HANDOVER_MAC_LENGTH);
+    memcpy(&message[index->oob_password.offset], credentials->public_key_hash, NBT_HANDOVER_PUBLIC_KEY_HASH_LENGTH);
+    memcpy(&message[index->ssid.offset], credentials->ssid, index->ssid.length);
+    if (index->channel.length == 2U)
+    {
+        message[index->channel.offset] = (uint8_t) (credentials->channel >> 8);
+        message[index->channel.offset + 1U] = (uint8_t) credentials->channel;
+    }
+    if (index->rf_bands.length == 1U)
+    {
+        message[index->rf_bands.offset] = credentials->rf_bands;
+    }
+}
+
+/**
+ * \brief Patches credentials into the message and writes only the changed bytes to the NDEF file.
+ *
+ * \details Must be called from the NBT I/O thread with the NBT application selected. The in-memory message is only
+ * updated if the write succeeded. The duration is stored in nbt_handover.last_apply_us and a warning is logged if it
+ * exceeds \c NBT_HANDOVER_ROTATION_BUDGET_US.
+ *
+ * \param[in] self Handover state.
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] credentials Credentials to be applied (SSID length must match the encoded SSID).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ * \see nbt_write_file_differences()
+ */
+ifx_status_t nbt_handover_apply(struct nbt_handover *self, nbt_cmd_t *nbt, const struct nbt_handover_credentials *credentials)
+{
+    if ((self == NULL) || (nbt == NULL) || (credentials == NULL) || (self->message == NULL) ||
+        (credentials->ssid_length != self->index.ssid.length))
+    {
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_APPLY, IFX_ILLEGAL_ARGUMENT);
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    uint8_t *patched = (uint8_t *) malloc(self->message_length);
+    if (patched == NULL)
+    {
+        return IFX_ERROR(LIB_NBT_HANDOVER, NBT_HANDOVER_APPLY, IFX_OUT_OF_MEMORY);
+    }
+    memcpy(patched, self->message, self->message_length);
+    nbt_handover_patch(self, credentials, patched);
+
+    size_t written = 0U;
+    ifx_status_t status = nbt_write_file_differences(nbt, NBT_FILEID_NDEF, 0U, self->message, patched, self->message_length, &written);
+    if (!ifx_error_check(status))
+    {
+        memcpy(self->message, patched, self->message_length);
+    }
+    free(patched);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not patch handover message in NDEF file");
+        return status;
+    }
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    self->last_apply_us = ((uint64_t) (end.tv_sec - start.tv_sec) * 1000000U) + ((uint64_t) end.tv_nsec / 1000U) - ((uint64_t) start.tv_nsec / 1000U);
+    if (self->last_apply_us > NBT_HANDOVER_ROTATION_BUDGET_US)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Handover patch took %llu us (budget %u us)", (unsigned long long) self->last_apply_us,
+                       NBT_HANDOVER_ROTATION_BUDGET_US);
+    }
+    ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_DEBUG, "Patched %zu bytes of handover message in %llu us", written,
+                   (unsigned long long) self->last_apply_us);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Prepares the next rotation: generates fresh credentials and configures the group owner for them.
+ *
+ * \details Must be called outside the NBT I/O thread before submitting nbt_handover_rotate_job(). The tag keeps
+ * advertising the previous credentials if the group owner could not be configured.
+ *
+ * \param[in] self Handover state.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_prepare_rotation(struct nbt_handover *self)
+{
+    struct nbt_handover_credentials credentials;
+    ifx_status_t status = nbt_handover_generate_credentials(self, &credentials);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    status = nbt_handover_apply_go(&credentials);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not configure P2P group owner for new credentials");
+        return status;
+    }
+    self->next = credentials;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Scheduler job writing the credentials prepared by nbt_handover_prepare_rotation() to the tag.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] context struct nbt_handover.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ * \see nbt_scheduler_submit()
+ */
+ifx_status_t nbt_handover_rotate_job(nbt_cmd_t *nbt, void *context)
+{
+    struct nbt_handover *self = (struct nbt_handover *) context;
+    ifx_status_t status = nbt_handover_apply(self, nbt, &self->next);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    self->rotations++;
+    return IFX_SUCCESS;
+}
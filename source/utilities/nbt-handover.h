@@ -0,0 +1,340 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-handover.h
+ * \brief In-place patching of the WiFi P2P connection handover NDEF message and per-session credential rotation.
+ *
+ * \details The handover message is encoded once (see \c scripts/create_NDEF_message.py). Afterwards only the mutable
+ * Wi-Fi Simple Configuration attributes (MAC address, OOB password, SSID, channel, RF bands) are patched in place and the
+ * changed bytes are written with partial UPDATE BINARY commands, so the message never has to be re-encoded or rewritten.
+ *
+ * A rotation first configures the P2P group owner in \c wpa_supplicant for fresh credentials (SSID and passphrase of a
+ * persistent group, see nbt_handover_apply_go()) and then writes the new SSID and OOB public key hash to the tag within
+ * \c NBT_HANDOVER_ROTATION_BUDGET_US (see nbt_handover_rotate_job()). The MAC address identifies the P2P device and is
+ * kept.
+ */
+#ifndef NBT_HANDOVER_H
+#define NBT_HANDOVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/nbt-cmd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Identifier for the handover utilities used in error codes.
+ */
+#define LIB_NBT_HANDOVER 0x62U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_handover_index_build().
+ */
+#define NBT_HANDOVER_INDEX_BUILD 0x01U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_handover_initialize().
+ */
+#define NBT_HANDOVER_INITIALIZE 0x02U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_handover_generate_credentials().
+ */
+#define NBT_HANDOVER_GENERATE_CREDENTIALS 0x03U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_handover_apply().
+ */
+#define NBT_HANDOVER_APPLY 0x04U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_handover_apply_go().
+ */
+#define NBT_HANDOVER_APPLY_GO 0x05U
+
+/**
+ * \brief Length of a MAC address in bytes.
+ */
+#define NBT_HANDOVER_MAC_LENGTH 6U
+
+/**
+ * \brief Length of the public key hash in the OOB device password attribute.
+ */
+#define NBT_HANDOVER_PUBLIC_KEY_HASH_LENGTH 20U
+
+/**
+ * \brief Maximum SSID length in bytes.
+ */
+#define NBT_HANDOVER_SSID_MAX_LENGTH 32U
+
+/**
+ * \brief Length of the Wi-Fi Direct SSID prefix (\c "DIRECT-") that is kept during rotation.
+ */
+#define NBT_HANDOVER_SSID_PREFIX_LENGTH 7U
+
+/**
+ * \brief Number of random SSID characters following the prefix that are rotated.
+ */
+#define NBT_HANDOVER_SSID_RANDOM_LENGTH 2U
+
+/**
+ * \brief Length of the generated WPA2 passphrase of the group owner (8 to 63 characters are allowed).
+ */
+#define NBT_HANDOVER_PASSPHRASE_LENGTH 16U
+
+/**
+ * \brief Rotation time budget in microseconds for writing the patched message (rotation runs between two taps).
+ */
+#define NBT_HANDOVER_ROTATION_BUDGET_US 50000U
+
+/**
+ * \brief P2P device interface of \c wpa_supplicant the group owner is configured on.
+ */
+#define NBT_HANDOVER_GO_INTERFACE "p2p-dev-wlan0"
+
+/**
+ * \brief Value of \c id_str marking the persistent group network created by nbt_handover_apply_go().
+ */
+#define NBT_HANDOVER_GO_ID_STR "nbt-rpi"
+
+/**
+ * \brief Wi-Fi Simple Configuration RF band value for 2.4 GHz.
+ */
+#define NBT_HANDOVER_RF_BAND_2_4GHZ 0x01U
+
+/**
+ * \brief Wi-Fi Simple Configuration RF band value for 5 GHz.
+ */
+#define NBT_HANDOVER_RF_BAND_5GHZ 0x02U
+
+/** \struct nbt_handover_field
+ * \brief Location of a mutable attribute value within the handover message.
+ */
+struct nbt_handover_field
+{
+    /**
+     * \brief Offset of attribute value from the start of the NDEF file (including NLEN).
+     */
+    uint16_t offset;
+
+    /**
+     * \brief Length of attribute value (0 if attribute is not present).
+     */
+    uint16_t length;
+};
+
+/** \struct nbt_handover_index
+ * \brief Offset index of all mutable fields in the handover message.
+ */
+struct nbt_handover_index
+{
+    /**
+     * \brief MAC address attribute (0x1020).
+     */
+    struct nbt_handover_field mac;
+
+    /**
+     * \brief OOB device password attribute (0x102C): public key hash, password ID, device password.
+     */
+    struct nbt_handover_field oob_password;
+
+    /**
+     * \brief SSID attribute (0x1045).
+     */
+    struct nbt_handover_field ssid;
+
+    /**
+     * \brief AP channel attribute (0x1001).
+     */
+    struct nbt_handover_field channel;
+
+    /**
+     * \brief RF bands attribute (0x103C).
+     */
+    struct nbt_handover_field rf_bands;
+};
+
+/** \struct nbt_handover_credentials
+ * \brief Values of the mutable handover fields.
+ */
+struct nbt_handover_credentials
+{
+    /**
+     * \brief P2P device MAC address.
+     */
+    uint8_t mac[NBT_HANDOVER_MAC_LENGTH];
+
+    /**
+     * \brief Public key hash of the OOB device password.
+     */
+    uint8_t public_key_hash[NBT_HANDOVER_PUBLIC_KEY_HASH_LENGTH];
+
+    /**
+     * \brief SSID (length is fixed by the encoded message).
+     */
+    uint8_t ssid[NBT_HANDOVER_SSID_MAX_LENGTH];
+
+    /**
+     * \brief Number of valid bytes in nbt_handover_credentials.ssid.
+     */
+    size_t ssid_length;
+
+    /**
+     * \brief Advertised AP channel.
+     */
+    uint16_t channel;
+
+    /**
+     * \brief Advertised RF band (\c NBT_HANDOVER_RF_BAND_2_4GHZ or \c NBT_HANDOVER_RF_BAND_5GHZ).
+     */
+    uint8_t rf_bands;
+
+    /**
+     * \brief WPA2 passphrase of the group owner (not part of the message, handed to the peer by WPS, empty if unknown).
+     */
+    char passphrase[NBT_HANDOVER_PASSPHRASE_LENGTH + 1U];
+};
+
+/** \struct nbt_handover
+ * \brief Handover message as currently stored on the tag plus its field index.
+ */
+struct nbt_handover
+{
+    /**
+     * \brief Message as stored in the NDEF file (including NLEN), patched in place.
+     */
+    uint8_t *message;
+
+    /**
+     * \brief Number of bytes in nbt_handover.message.
+     */
+    size_t message_length;
+
+    /**
+     * \brief Offsets of the mutable fields.
+     */
+    struct nbt_handover_index index;
+
+    /**
+     * \brief Credentials prepared by nbt_handover_prepare_rotation() for the next nbt_handover_rotate_job().
+     */
+    struct nbt_handover_credentials next;
+
+    /**
+     * \brief Number of successful rotations.
+     */
+    uint32_t rotations;
+
+    /**
+     * \brief Duration of last nbt_handover_apply() in microseconds.
+     */
+    uint64_t last_apply_us;
+};
+
+/**
+ * \brief Builds offset index of the mutable fields by walking the NDEF records and WSC attributes once.
+ *
+ * \param[in] message NDEF file contents (including 2 byte NLEN).
+ * \param[in] message_length Number of bytes in \c message.
+ * \param[out] index Offset index.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_index_build(const uint8_t *message, size_t message_length, struct nbt_handover_index *index);
+
+/**
+ * \brief Initializes handover state for a message that is already stored in the NDEF file.
+ *
+ * \param[in] self Handover state.
+ * \param[in] message Message buffer as written to the NDEF file (patched in place later on).
+ * \param[in] message_length Number of bytes in \c message.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_initialize(struct nbt_handover *self, uint8_t *message, size_t message_length);
+
+/**
+ * \brief Reads current field values from the message.
+ *
+ * \param[in] self Handover state.
+ * \param[out] credentials Current field values.
+ */
+void nbt_handover_get_credentials(const struct nbt_handover *self, struct nbt_handover_credentials *credentials);
+
+/**
+ * \brief Generates fresh per-session credentials based on the current ones.
+ *
+ * \details Replaces the OOB public key hash, the random SSID characters following \c "DIRECT-" and the passphrase with
+ * random values. MAC address, channel and band are kept and may be adjusted by the caller before applying.
+ *
+ * \param[in] self Handover state.
+ * \param[out] credentials Fresh credentials.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_generate_credentials(const struct nbt_handover *self, struct nbt_handover_credentials *credentials);
+
+/**
+ * \brief Configures (and persists) the P2P group owner in \c wpa_supplicant for the given SSID and passphrase.
+ *
+ * \details Replaces the persistent group network marked with \c NBT_HANDOVER_GO_ID_STR on \c NBT_HANDOVER_GO_INTERFACE
+ * by a new one with the given credentials, restarts the group owner on it and saves the configuration (requires
+ * \c update_config=1). Runs several \c wpa_cli commands, so it must not be called from the NBT I/O thread.
+ *
+ * \param[in] credentials Credentials to be used by the group owner.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_apply_go(const struct nbt_handover_credentials *credentials);
+
+/**
+ * \brief Patches credentials into a copy of the message without communicating with the NBT.
+ *
+ * \param[in] self Handover state providing the field index.
+ * \param[in] credentials Credentials to be patched (SSID length must match the encoded SSID).
+ * \param[in,out] message Buffer of nbt_handover.message_length bytes with the same layout as nbt_handover.message.
+ */
+void nbt_handover_patch(const struct nbt_handover *self, const struct nbt_handover_credentials *credentials, uint8_t *message);
+
+/**
+ * \brief Patches credentials into the message and writes only the changed bytes to the NDEF file.
+ *
+ * \details Must be called from the NBT I/O thread with the NBT application selected. The in-memory message is only
+ * updated if the write succeeded. The duration is stored in nbt_handover.last_apply_us and a warning is logged if it
+ * exceeds \c NBT_HANDOVER_ROTATION_BUDGET_US.
+ *
+ * \param[in] self Handover state.
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] credentials Credentials to be applied (SSID length must match the encoded SSID).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ * \see nbt_write_file_differences()
+ */
+ifx_status_t nbt_handover_apply(struct nbt_handover *self, nbt_cmd_t *nbt, const struct nbt_handover_credentials *credentials);
+
+/**
+ * \brief Prepares the next rotation: generates fresh credentials and configures the group owner for them.
+ *
+ * \details Must be called outside the NBT I/O thread before submitting nbt_handover_rotate_job(). The tag keeps
+ * advertising the previous credentials if the group owner could not be configured.
+ *
+ * \param[in] self Handover state.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_handover_prepare_rotation(struct nbt_handover *self);
+
+/**
+ * \brief Scheduler job writing the credentials prepared by nbt_handover_prepare_rotation() to the tag.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] context struct nbt_handover.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ * \see nbt_scheduler_submit()
+ */
+ifx_status_t nbt_handover_rotate_job(nbt_cmd_t *nbt, void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NBT_HANDOVER_H
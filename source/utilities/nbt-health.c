@@ -0,0 +1,451 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-health.c
+ * \brief Periodic low-cost tag liveness probe with latency SLO tracking.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-logger.h"
+#include "infineon/ifx-protocol.h"
+#include "infineon/nbt-cmd.h"
+
+#include "nbt-bus-lock.h"
+#include "nbt-health.h"
+#include "nbt-ringlog.h"
+#include "nbt-scheduler.h"
+#include "nbt-utilities.h"
+
+/**
+ * \brief String used as source information for logging.
+ */
+#define LOG_TAG "NBT health"
+
+/**
+ * \brief Number of capability container bytes read by a probe (CCLEN).
+ */
+#define NBT_HEALTH_PROBE_LENGTH 2U
+
+/**
+ * \brief Comparison function for qsort() of latencies.
+ *
+ * \param[in] a First latency.
+ * \param[in] b Second latency.
+ * \return int Ordering of \c a relative to \c b.
+ */
+static int nbt_health_compare(const void *a, const void *b)
+{
+    uint32_t left = *(const uint32_t *) a;
+    uint32_t right = *(const uint32_t *) b;
+    return (left > right) - (left < right);
+}
+
+/**
+ * \brief Scheduler job performing a single probe (and reactivation once the error threshold is crossed).
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] context struct nbt_health.
+ * \return ifx_status_t Probe result.
+ */
+static ifx_status_t nbt_health_probe_job(nbt_cmd_t *nbt, void *context)
+{
+    struct nbt_health *self = (struct nbt_health *) context;
+    uint8_t cclen[NBT_HEALTH_PROBE_LENGTH];
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ifx_status_t status = nbt_read_file(nbt, NBT_FILEID_CC, 0U, sizeof(cclen), cclen);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t latency_us = ((uint64_t) (end.tv_sec - start.tv_sec) * 1000000U) + ((uint64_t) end.tv_nsec / 1000U) - ((uint64_t) start.tv_nsec / 1000U);
+
+    pthread_mutex_lock(&self->lock);
+    struct nbt_health_report *counters = &self->counters;
+    counters->probes++;
+    counters->last_status = status;
+    counters->alive = !ifx_error_check(status);
+    bool reactivate = false;
+    if (ifx_error_check(status))
+    {
+        counters->failures++;
+        counters->error_streak++;
+        if (counters->error_streak > counters->max_error_streak)
+        {
+            counters->max_error_streak = counters->error_streak;
+        }
+        reactivate = (counters->error_streak % self->config.error_threshold) == 0U;
+    }
+    else
+    {
+        counters->error_streak = 0U;
+        self->latencies[self->latencies_next] = (latency_us > UINT32_MAX) ? UINT32_MAX : (uint32_t) latency_us;
+        self->latencies_next = (self->latencies_next + 1U) % NBT_HEALTH_WINDOW;
+        if (self->latencies_count < NBT_HEALTH_WINDOW)
+        {
+            self->latencies_count++;
+        }
+        if (latency_us > self->config.slo_us)
+        {
+            counters->slo_violations++;
+        }
+    }
+    pthread_mutex_unlock(&self->lock);
+
+    if (reactivate)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "%u consecutive probe errors, reactivating NBT", self->config.error_threshold);
+        ifx_status_t reactivation = ifx_protocol_activate(self->protocol, NULL, NULL);
+        if (!ifx_error_check(reactivation))
+        {
+            reactivation = nbt_select_nbt_application(nbt);
+        }
+        if (ifx_error_check(reactivation))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not reactivate NBT");
+        }
+        pthread_mutex_lock(&self->lock);
+        self->counters.reactivations++;
+        pthread_mutex_unlock(&self->lock);
+    }
+    return status;
+}
+
+/**
+ * \brief Saturates counter to the given maximum.
+ *
+ * \param[in] value Counter value.
+ * \param[in] maximum Largest representable value.
+ * \return uint32_t \c value or \c maximum, whichever is smaller.
+ */
+static uint32_t nbt_health_saturate(uint64_t value, uint32_t maximum)
+{
+    return (value > maximum) ? maximum : (uint32_t) value;
+}
+
+/**
+ * \brief Appends STATUS record with the current report to the telemetry ring log.
+ *
+ * \details Must not be called from the NBT I/O thread, the flush is executed as scheduler job.
+ *
+ * \param[in] self Health monitor with configured telemetry ring log.
+ * \param[in] flush \c true to flush the ring log even if the batch is not complete.
+ */
+static void nbt_health_record_status(struct nbt_health *self, bool flush)
+{
+    struct nbt_health_report report;
+    nbt_health_get_report(self, &report);
+
+    uint32_t probes = nbt_health_saturate(report.probes, UINT32_MAX);
+    uint32_t failures = nbt_health_saturate(report.failures, UINT32_MAX);
+    uint32_t reactivations = nbt_health_saturate(report.reactivations, UINT16_MAX);
+    uint8_t payload[NBT_HEALTH_STATUS_RECORD_SIZE];
+    payload[0] = (uint8_t) (probes >> 24);
+    payload[1] = (uint8_t) (probes >> 16);
+    payload[2] = (uint8_t) (probes >> 8);
+    payload[3] = (uint8_t) probes;
+    payload[4] = (uint8_t) (failures >> 24);
+    payload[5] = (uint8_t) (failures >> 16);
+    payload[6] = (uint8_t) (failures >> 8);
+    payload[7] = (uint8_t) failures;
+    payload[8] = (uint8_t) (reactivations >> 8);
+    payload[9] = (uint8_t) reactivations;
+    payload[10] = (uint8_t) nbt_health_saturate(report.error_streak, UINT8_MAX);
+    payload[11] = report.alive ? 0x01U : 0x00U;
+    payload[12] = (uint8_t) (report.p50_us >> 24);
+    payload[13] = (uint8_t) (report.p50_us >> 16);
+    payload[14] = (uint8_t) (report.p50_us >> 8);
+    payload[15] = (uint8_t) report.p50_us;
+    payload[16] = (uint8_t) (report.p99_us >> 24);
+    payload[17] = (uint8_t) (report.p99_us >> 16);
+    payload[18] = (uint8_t) (report.p99_us >> 8);
+    payload[19] = (uint8_t) report.p99_us;
+
+    bool flush_due = false;
+    if (ifx_error_check(nbt_ringlog_append(self->config.telemetry, NBT_RINGLOG_TYPE_STATUS, payload, sizeof(payload), &flush_due)))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Could not stage status record");
+        return;
+    }
+    if ((flush || flush_due) &&
+        ifx_error_check(nbt_scheduler_execute(self->scheduler, NBT_PRIORITY_STATUS, nbt_ringlog_flush_job, self->config.telemetry)))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Could not flush telemetry ring log");
+    }
+}
+
+/**
+ * \brief Monitor thread submitting jittered probes until stopped.
+ *
+ * \param[in] arg struct nbt_health.
+ * \return void * Always \c NULL.
+ */
+static void *nbt_health_thread(void *arg)
+{
+    struct nbt_health *self = (struct nbt_health *) arg;
+    unsigned int seed = (unsigned int) time(NULL) ^ (unsigned int) getpid();
+    uint32_t probes_since_status = 0U;
+
+    pthread_mutex_lock(&self->lock);
+    while (self->running)
+    {
+        // Jitter interval so probes drift relative to periodic real traffic
+        int64_t interval_us = (int64_t) self->config.interval_ms * 1000;
+        int64_t jitter_us = (interval_us * (int64_t) self->config.jitter_percent) / 100;
+        if (jitter_us > 0)
+        {
+            interval_us += ((int64_t) rand_r(&seed) % ((2 * jitter_us) + 1)) - jitter_us;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += (time_t) (interval_us / 1000000);
+        deadline.tv_nsec += (long) ((interval_us % 1000000) * 1000);
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        int wait_status = 0;
+        while (self->running && (wait_status != ETIMEDOUT))
+        {
+            wait_status = pthread_cond_timedwait(&self->wakeup, &self->lock, &deadline);
+        }
+        if (!self->running)
+        {
+            break;
+        }
+        pthread_mutex_unlock(&self->lock);
+
+        nbt_scheduler_execute(self->scheduler, NBT_PRIORITY_PROBE, nbt_health_probe_job, self);
+        if (self->config.status_path != NULL)
+        {
+            nbt_health_export(self, self->config.status_path);
+        }
+        if ((self->config.telemetry != NULL) && (++probes_since_status >= self->config.telemetry_probes))
+        {
+            nbt_health_record_status(self, false);
+            probes_since_status = 0U;
+        }
+
+        pthread_mutex_lock(&self->lock);
+    }
+    pthread_mutex_unlock(&self->lock);
+    return NULL;
+}
+
+/**
+ * \brief Starts health monitor thread.
+ *
+ * \param[in] self Health monitor.
+ * \param[in] scheduler Running NBT scheduler.
+ * \param[in] protocol Protocol stack used by the scheduler's NBT abstraction (reactivated on error streaks, its statistics
+ * are exported if it is a bus lock layer).
+ * \param[in] config Configuration (may be \c NULL for defaults).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_health_start(struct nbt_health *self, struct nbt_scheduler *scheduler, ifx_protocol_t *protocol,
+                              const struct nbt_health_config *config)
+{
+    if ((self == NULL) || (scheduler == NULL) || (protocol == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_HEALTH, NBT_HEALTH_START, IFX_ILLEGAL_ARGUMENT);
+    }
+    memset(self, 0, sizeof(struct nbt_health));
+    if (config != NULL)
+    {
+        self->config = *config;
+    }
+    if (self->config.interval_ms == 0U)
+    {
+        self->config.interval_ms = NBT_HEALTH_DEFAULT_INTERVAL_MS;
+    }
+    if (self->config.jitter_percent == 0U)
+    {
+        self->config.jitter_percent = NBT_HEALTH_DEFAULT_JITTER_PERCENT;
+    }
+    if (self->config.jitter_percent > 100U)
+    {
+        self->config.jitter_percent = 100U;
+    }
+    if (self->config.error_threshold == 0U)
+    {
+        self->config.error_threshold = NBT_HEALTH_DEFAULT_ERROR_THRESHOLD;
+    }
+    if (self->config.slo_us == 0U)
+    {
+        self->config.slo_us = NBT_HEALTH_DEFAULT_SLO_US;
+    }
+    if (self->config.telemetry_probes == 0U)
+    {
+        self->config.telemetry_probes = NBT_HEALTH_DEFAULT_TELEMETRY_PROBES;
+    }
+    self->scheduler = scheduler;
+    self->protocol = protocol;
+    self->counters.alive = true;
+
+    pthread_condattr_t attributes;
+    if (pthread_condattr_init(&attributes) != 0)
+    {
+        return IFX_ERROR(LIB_NBT_HEALTH, NBT_HEALTH_START, IFX_UNSPECIFIED_ERROR);
+    }
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    int cond_status = pthread_cond_init(&self->wakeup, &attributes);
+    pthread_condattr_destroy(&attributes);
+    if (cond_status != 0)
+    {
+        return IFX_ERROR(LIB_NBT_HEALTH, NBT_HEALTH_START, IFX_UNSPECIFIED_ERROR);
+    }
+    if (pthread_mutex_init(&self->lock, NULL) != 0)
+    {
+        pthread_cond_destroy(&self->wakeup);
+        return IFX_ERROR(LIB_NBT_HEALTH, NBT_HEALTH_START, IFX_UNSPECIFIED_ERROR);
+    }
+    self->running = true;
+    if (pthread_create(&self->thread, NULL, nbt_health_thread, self) != 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not create health monitor thread");
+        pthread_mutex_destroy(&self->lock);
+        pthread_cond_destroy(&self->wakeup);
+        return IFX_ERROR(LIB_NBT_HEALTH, NBT_HEALTH_START, IFX_UNSPECIFIED_ERROR);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Returns snapshot of current health state including latency percentiles.
+ *
+ * \param[in] self Health monitor.
+ * \param[out] report Current state.
+ */
+void nbt_health_get_report(struct nbt_health *self, struct nbt_health_report *report)
+{
+    uint32_t sorted[NBT_HEALTH_WINDOW];
+    pthread_mutex_lock(&self->lock);
+    *report = self->counters;
+    size_t count = self->latencies_count;
+    memcpy(sorted, self->latencies, count * sizeof(uint32_t));
+    pthread_mutex_unlock(&self->lock);
+
+    report->p50_us = 0U;
+    report->p90_us = 0U;
+    report->p99_us = 0U;
+    report->max_us = 0U;
+    if (count > 0U)
+    {
+        // Nearest-rank percentiles over the rolling window
+        qsort(sorted, count, sizeof(uint32_t), nbt_health_compare);
+        report->p50_us = sorted[((count * 50U) + 99U) / 100U - 1U];
+        report->p90_us = sorted[((count * 90U) + 99U) / 100U - 1U];
+        report->p99_us = sorted[((count * 99U) + 99U) / 100U - 1U];
+        report->max_us = sorted[count - 1U];
+    }
+}
+
+/**
+ * \brief Atomically writes current health state as \c key=value lines to a file.
+ *
+ * \details Includes the \c bus_lock_* statistics if the monitored protocol is a bus lock layer (see nbt-bus-lock.h).
+ * The state is written to a new file with a unique name in the destination directory (never following an existing
+ * file or symlink) that is then renamed to \c path.
+ *
+ * \param[in] self Health monitor.
+ * \param[in] path Destination file.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_health_export(struct nbt_health *self, const char *path)
+{
+    if ((self == NULL) || (path == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_HEALTH, NBT_HEALTH_EXPORT, IFX_ILLEGAL_ARGUMENT);
+    }
+    struct nbt_health_report report;
+    nbt_health_get_report(self, &report);
+
+    char temporary_path[4096];
+    if (snprintf(temporary_path, sizeof(temporary_path), "%s.XXXXXX", path) >= (int) sizeof(temporary_path))
+    {
+        return IFX_ERROR(LIB_NBT_HEALTH, NBT_HEALTH_EXPORT, IFX_ILLEGAL_ARGUMENT);
+    }
+    // mkstemp() creates the file exclusively with mode 0600, the status is meant to be world readable
+    int fd = mkstemp(temporary_path);
+    FILE *file = NULL;
+    if ((fd == -1) || (fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0) || ((file = fdopen(fd, "w")) == NULL))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not create health status file %s", temporary_path);
+        if (fd != -1)
+        {
+            close(fd);
+            unlink(temporary_path);
+        }
+        return IFX_ERROR(LIB_NBT_HEALTH, NBT_HEALTH_EXPORT, IFX_UNSPECIFIED_ERROR);
+    }
+    fprintf(file, "alive=%d\n", report.alive ? 1 : 0);
+    fprintf(file, "last_status=0x%08X\n", (unsigned int) report.last_status);
+    fprintf(file, "probes=%llu\n", (unsigned long long) report.probes);
+    fprintf(file, "failures=%llu\n", (unsigned long long) report.failures);
+    fprintf(file, "error_streak=%u\n", report.error_streak);
+    fprintf(file, "max_error_streak=%u\n", report.max_error_streak);
+    fprintf(file, "reactivations=%llu\n", (unsigned long long) report.reactivations);
+    fprintf(file, "slo_us=%u\n", self->config.slo_us);
+    fprintf(file, "slo_violations=%llu\n", (unsigned long long) report.slo_violations);
+    fprintf(file, "latency_p50_us=%u\n", report.p50_us);
+    fprintf(file, "latency_p90_us=%u\n", report.p90_us);
+    fprintf(file, "latency_p99_us=%u\n", report.p99_us);
+    fprintf(file, "latency_max_us=%u\n", report.max_us);
+    struct nbt_bus_lock_metrics bus_lock;
+    if (!ifx_error_check(nbt_bus_lock_get_metrics(self->protocol, &bus_lock)))
+    {
+        uint64_t acquisitions = (bus_lock.acquisitions > 0U) ? bus_lock.acquisitions : 1U;
+        fprintf(file, "bus_lock_acquisitions=%llu\n", (unsigned long long) bus_lock.acquisitions);
+        fprintf(file, "bus_lock_contended=%llu\n", (unsigned long long) bus_lock.contended);
+        fprintf(file, "bus_lock_timeouts=%llu\n", (unsigned long long) bus_lock.timeouts);
+        fprintf(file, "bus_lock_wait_avg_us=%llu\n", (unsigned long long) (bus_lock.wait_total_ns / acquisitions / 1000U));
+        fprintf(file, "bus_lock_wait_max_us=%llu\n", (unsigned long long) (bus_lock.wait_max_ns / 1000U));
+        fprintf(file, "bus_lock_hold_avg_us=%llu\n", (unsigned long long) (bus_lock.hold_total_ns / acquisitions / 1000U));
+        fprintf(file, "bus_lock_hold_max_us=%llu\n", (unsigned long long) (bus_lock.hold_max_ns / 1000U));
+    }
+    if ((fclose(file) != 0) || (rename(temporary_path, path) != 0))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not write health status file %s", path);
+        unlink(temporary_path);
+        return IFX_ERROR(LIB_NBT_HEALTH, NBT_HEALTH_EXPORT, IFX_UNSPECIFIED_ERROR);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Stops health monitor thread and frees resources.
+ *
+ * \details Appends a final STATUS record to the telemetry ring log and flushes it, so the scheduler must still be
+ * running.
+ *
+ * \param[in] self Health monitor.
+ */
+void nbt_health_stop(struct nbt_health *self)
+{
+    if (self == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&self->lock);
+    self->running = false;
+    pthread_cond_broadcast(&self->wakeup);
+    pthread_mutex_unlock(&self->lock);
+    pthread_join(self->thread, NULL);
+    if (self->config.telemetry != NULL)
+    {
+        nbt_health_record_status(self, true);
+    }
+    pthread_cond_destroy(&self->wakeup);
+    pthread_mutex_destroy(&self->lock);
+}
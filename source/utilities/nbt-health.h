@@ -0,0 +1,312 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-health.h
+ * \brief Periodic low-cost tag liveness probe with latency SLO tracking.
+ *
+ * \details A monitor thread periodically (with random jitter) submits a small READ BINARY of the capability container
+ * to the NBT scheduler. Probe latencies are kept in a rolling window to derive percentiles, consecutive errors are
+ * counted and the protocol is reactivated once an error streak crosses a threshold. The current state is exported as
+ * a \c key=value status file.
+ *
+ * If a telemetry ring log is configured, the monitor appends a \c NBT_RINGLOG_TYPE_STATUS record every
+ * nbt_health_config.telemetry_probes probes and once more when it is stopped. Record payload (big endian, counters
+ * saturated):
+ *
+ *   | Offset | Size | Content                                                    |
+ *   | ------ | ---- | ---------------------------------------------------------- |
+ *   | 0      | 4    | Number of executed probes                                  |
+ *   | 4      | 4    | Number of failed probes                                    |
+ *   | 8      | 2    | Number of reactivations                                    |
+ *   | 10     | 1    | Current error streak                                       |
+ *   | 11     | 1    | 0x01 if the last probe succeeded, 0x00 otherwise           |
+ *   | 12     | 4    | Median probe latency in microseconds                       |
+ *   | 16     | 4    | 99th percentile probe latency in microseconds              |
+ */
+#ifndef NBT_HEALTH_H
+#define NBT_HEALTH_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-protocol.h"
+#include "infineon/nbt-cmd.h"
+
+#include "nbt-ringlog.h"
+#include "nbt-scheduler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Identifier for the health monitor used in error codes.
+ */
+#define LIB_NBT_HEALTH 0x64U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_health_start().
+ */
+#define NBT_HEALTH_START 0x01U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_health_export().
+ */
+#define NBT_HEALTH_EXPORT 0x02U
+
+/**
+ * \brief Number of probe latencies kept for percentile calculation.
+ */
+#define NBT_HEALTH_WINDOW 128U
+
+/**
+ * \brief Default probe interval in milliseconds.
+ */
+#define NBT_HEALTH_DEFAULT_INTERVAL_MS 5000U
+
+/**
+ * \brief Default jitter in percent of the probe interval.
+ */
+#define NBT_HEALTH_DEFAULT_JITTER_PERCENT 20U
+
+/**
+ * \brief Default number of consecutive probe errors triggering a reactivation.
+ */
+#define NBT_HEALTH_DEFAULT_ERROR_THRESHOLD 3U
+
+/**
+ * \brief Default latency SLO in microseconds (single probe).
+ */
+#define NBT_HEALTH_DEFAULT_SLO_US 20000U
+
+/**
+ * \brief Default number of probes between two STATUS records in the telemetry ring log.
+ */
+#define NBT_HEALTH_DEFAULT_TELEMETRY_PROBES 60U
+
+/**
+ * \brief Length of the STATUS record payload written to the telemetry ring log.
+ */
+#define NBT_HEALTH_STATUS_RECORD_SIZE 20U
+
+/** \struct nbt_health_config
+ * \brief Health monitor configuration (zero values select the defaults).
+ */
+struct nbt_health_config
+{
+    /**
+     * \brief Probe interval in milliseconds.
+     */
+    uint32_t interval_ms;
+
+    /**
+     * \brief Random jitter applied to each interval in percent.
+     */
+    uint32_t jitter_percent;
+
+    /**
+     * \brief Number of consecutive errors triggering a reactivation.
+     */
+    uint32_t error_threshold;
+
+    /**
+     * \brief Latency SLO for a single probe in microseconds.
+     */
+    uint32_t slo_us;
+
+    /**
+     * \brief Path of exported status file (\c NULL to disable export).
+     */
+    const char *status_path;
+
+    /**
+     * \brief Telemetry ring log receiving STATUS records (\c NULL to disable).
+     */
+    struct nbt_ringlog *telemetry;
+
+    /**
+     * \brief Number of probes between two STATUS records.
+     */
+    uint32_t telemetry_probes;
+};
+
+/** \struct nbt_health_report
+ * \brief Snapshot of the health monitor state.
+ */
+struct nbt_health_report
+{
+    /**
+     * \brief Number of executed probes.
+     */
+    uint64_t probes;
+
+    /**
+     * \brief Number of failed probes.
+     */
+    uint64_t failures;
+
+    /**
+     * \brief Current number of consecutive failed probes.
+     */
+    uint32_t error_streak;
+
+    /**
+     * \brief Longest streak of failed probes so far.
+     */
+    uint32_t max_error_streak;
+
+    /**
+     * \brief Number of triggered reactivations.
+     */
+    uint64_t reactivations;
+
+    /**
+     * \brief Number of successful probes exceeding the latency SLO.
+     */
+    uint64_t slo_violations;
+
+    /**
+     * \brief Median probe latency of rolling window in microseconds.
+     */
+    uint32_t p50_us;
+
+    /**
+     * \brief 90th percentile probe latency of rolling window in microseconds.
+     */
+    uint32_t p90_us;
+
+    /**
+     * \brief 99th percentile probe latency of rolling window in microseconds.
+     */
+    uint32_t p99_us;
+
+    /**
+     * \brief Maximum probe latency of rolling window in microseconds.
+     */
+    uint32_t max_us;
+
+    /**
+     * \brief Status of last probe.
+     */
+    ifx_status_t last_status;
+
+    /**
+     * \brief \c true if the last probe succeeded.
+     */
+    bool alive;
+};
+
+/** \struct nbt_health
+ * \brief Health monitor state.
+ */
+struct nbt_health
+{
+    /**
+     * \brief Effective configuration.
+     */
+    struct nbt_health_config config;
+
+    /**
+     * \brief Scheduler used to run probes on the NBT I/O thread.
+     */
+    struct nbt_scheduler *scheduler;
+
+    /**
+     * \brief Protocol stack to be reactivated after an error streak.
+     */
+    ifx_protocol_t *protocol;
+
+    /**
+     * \brief Monitor thread.
+     */
+    pthread_t thread;
+
+    /**
+     * \brief Lock protecting all statistics and nbt_health.running.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * \brief Signalled to stop the monitor thread early.
+     */
+    pthread_cond_t wakeup;
+
+    /**
+     * \brief \c true while the monitor thread is running.
+     */
+    bool running;
+
+    /**
+     * \brief Rolling window of probe latencies in microseconds.
+     */
+    uint32_t latencies[NBT_HEALTH_WINDOW];
+
+    /**
+     * \brief Number of valid entries in nbt_health.latencies.
+     */
+    size_t latencies_count;
+
+    /**
+     * \brief Next write position in nbt_health.latencies.
+     */
+    size_t latencies_next;
+
+    /**
+     * \brief Counters exported in reports (percentiles are calculated on demand).
+     */
+    struct nbt_health_report counters;
+};
+
+/**
+ * \brief Starts health monitor thread.
+ *
+ * \param[in] self Health monitor.
+ * \param[in] scheduler Running NBT scheduler.
+ * \param[in] protocol Protocol stack used by the scheduler's NBT abstraction (reactivated on error streaks, its statistics
+ * are exported if it is a bus lock layer).
+ * \param[in] config Configuration (may be \c NULL for defaults).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_health_start(struct nbt_health *self, struct nbt_scheduler *scheduler, ifx_protocol_t *protocol,
+                              const struct nbt_health_config *config);
+
+/**
+ * \brief Returns snapshot of current health state including latency percentiles.
+ *
+ * \param[in] self Health monitor.
+ * \param[out] report Current state.
+ */
+void nbt_health_get_report(struct nbt_health *self, struct nbt_health_report *report);
+
+/**
+ * \brief Atomically writes current health state as \c key=value lines to a file.
+ *
+ * \details Includes the \c bus_lock_* statistics if the monitored protocol is a bus lock layer (see nbt-bus-lock.h).
+ * The state is written to a new file with a unique name in the destination directory (never following an existing
+ * file or symlink) that is then renamed to \c path.
+ *
+ * \param[in] self Health monitor.
+ * \param[in] path Destination file.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_health_export(struct nbt_health *self, const char *path);
+
+/**
+ * \brief Stops health monitor thread and frees resources.
+ *
+ * \details Appends a final STATUS record to the telemetry ring log and flushes it, so the scheduler must still be
+ * running.
+ *
+ * \param[in] self Health monitor.
+ */
+void nbt_health_stop(struct nbt_health *self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NBT_HEALTH_H
@@ -0,0 +1,919 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-image.c
+ * \brief Snapshot and restore of a complete NBT tag in a compact binary image.
+ */
+#include <endian.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-logger.h"
+#include "infineon/nbt-apdu.h"
+#include "infineon/nbt-cmd.h"
+
+#include "nbt-image.h"
+#include "nbt-utilities.h"
+
+/**
+ * \brief String used as source information for logging.
+ */
+#define LOG_TAG "NBT image"
+
+/**
+ * \brief Size of a file access policy entry in a \c NBT_IMAGE_SECTION_FAP section.
+ */
+#define NBT_IMAGE_FAP_ENTRY_SIZE 6U
+
+/**
+ * \brief Maximum length of a capability container that is dumped.
+ */
+#define NBT_IMAGE_CC_MAX_SIZE 0xFFU
+
+/**
+ * \brief Upper bound for the length of a dumped image.
+ */
+#define NBT_IMAGE_MAX_LENGTH                                                                                                                \
+    (sizeof(struct nbt_image_header) + (NBT_IMAGE_MAX_SECTIONS * (sizeof(struct nbt_image_section) + NBT_IMAGE_ALIGNMENT)) +             \
+     NBT_IMAGE_CC_MAX_SIZE + NBT_IMAGE_NDEF_FILE_SIZE + (4U * NBT_PROPRIETARY_FILE_SIZE) + (NBT_IMAGE_FAP_COUNT * NBT_IMAGE_FAP_ENTRY_SIZE) + \
+     sizeof(NBT_IMAGE_CONFIG_TAGS))
+
+/**
+ * \brief Proprietary files contained in every image (in this order).
+ */
+static const enum nbt_fileid NBT_IMAGE_PROPRIETARY_FILES[] = {NBT_FILEID_PROPRIETARY1, NBT_FILEID_PROPRIETARY2, NBT_FILEID_PROPRIETARY3,
+                                                               NBT_FILEID_PROPRIETARY4};
+
+/**
+ * \brief Configurator settings contained in every image.
+ */
+static const nbt_configurator_tags NBT_IMAGE_CONFIG_TAGS[] = {NBT_TAG_COMMUNICATION_INTERFACE_ENABLE, NBT_TAG_GPIO_FUNCTION};
+
+/**
+ * \brief Extracts value of a single byte configurator setting from a GET CONFIGURATION response.
+ *
+ * \details The configurator answers with the requested data object (tag, length 0x01, value). All settings stored in
+ * images are single bytes, so any other encoding (other tag, longer value, trailing bytes) is rejected rather than
+ * guessed.
+ *
+ * \param[in] tag Requested configurator tag.
+ * \param[in] data Response data without status word.
+ * \param[in] data_len Number of bytes in \c data.
+ * \param[out] value Setting value.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_image_parse_config_value(nbt_configurator_tags tag, const uint8_t *data, size_t data_len, uint8_t *value)
+{
+    if ((data_len != 3U) || (data[0] != (uint8_t) tag) || (data[1] != 0x01U))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Unsupported encoding of configuration 0x%02X (%zu bytes)", (unsigned int) tag,
+                       data_len);
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_DUMP, NBT_IMAGE_INVALID);
+    }
+    *value = data[2];
+    return IFX_SUCCESS;
+}
+
+/** \struct nbt_image_builder
+ * \brief Incrementally assembles an image in a preallocated buffer.
+ */
+struct nbt_image_builder
+{
+    /**
+     * \brief Image buffer of \c NBT_IMAGE_MAX_LENGTH bytes.
+     */
+    uint8_t *buffer;
+
+    /**
+     * \brief Section table entries (host byte order, encoded on nbt_image_finish()).
+     */
+    struct nbt_image_section sections[NBT_IMAGE_MAX_SECTIONS];
+
+    /**
+     * \brief Number of used entries in nbt_image_builder.sections.
+     */
+    uint16_t section_count;
+
+    /**
+     * \brief Offset of next section data.
+     */
+    size_t length;
+};
+
+/**
+ * \brief Calculates CRC-32/ISO-HDLC over data.
+ *
+ * \param[in] data Data to be checksummed.
+ * \param[in] length Number of bytes in \c data.
+ * \return uint32_t CRC.
+ */
+static uint32_t nbt_image_crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0U; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0U; bit < 8U; bit++)
+        {
+            crc = (crc & 1U) ? ((crc >> 1) ^ 0xEDB88320U) : (crc >> 1);
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * \brief Reserves space for the data of a new section.
+ *
+ * \param[in] builder Image builder.
+ * \param[in] kind Section kind.
+ * \param[in] id Section identifier.
+ * \param[in] length Number of bytes to be reserved.
+ * \return struct nbt_image_section * New section table entry (data at nbt_image_builder.buffer + offset).
+ */
+static struct nbt_image_section *nbt_image_add_section(struct nbt_image_builder *builder, enum nbt_image_section_kind kind, uint16_t id,
+                                                       size_t length)
+{
+    struct nbt_image_section *section = &builder->sections[builder->section_count++];
+    section->id = id;
+    section->kind = (uint8_t) kind;
+    section->flags = 0U;
+    section->offset = (uint32_t) builder->length;
+    section->length = (uint32_t) length;
+    builder->length = (builder->length + length + NBT_IMAGE_ALIGNMENT - 1U) & ~((size_t) NBT_IMAGE_ALIGNMENT - 1U);
+    return section;
+}
+
+/**
+ * \brief Marks section as unreadable and drops its data.
+ *
+ * \param[in] builder Image builder.
+ * \param[in] section Last section added with nbt_image_add_section().
+ */
+static void nbt_image_drop_section(struct nbt_image_builder *builder, struct nbt_image_section *section)
+{
+    builder->length = section->offset;
+    section->length = 0U;
+    section->flags |= NBT_IMAGE_FLAG_UNREADABLE;
+}
+
+/**
+ * \brief Encodes header and section table (including checksums) into image buffer.
+ *
+ * \param[in] builder Image builder.
+ */
+static void nbt_image_finish(struct nbt_image_builder *builder)
+{
+    struct nbt_image_header header;
+    memcpy(header.magic, NBT_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = htole16(NBT_IMAGE_VERSION);
+    header.section_count = htole16(builder->section_count);
+    header.length = htole32((uint32_t) builder->length);
+    header.timestamp = htole32((uint32_t) time(NULL));
+    memcpy(builder->buffer, &header, sizeof(header));
+
+    for (uint16_t i = 0U; i < builder->section_count; i++)
+    {
+        const struct nbt_image_section *section = &builder->sections[i];
+        struct nbt_image_section encoded = {.id = htole16(section->id),
+                                            .kind = section->kind,
+                                            .flags = section->flags,
+                                            .offset = htole32(section->offset),
+                                            .length = htole32(section->length),
+                                            .crc32 = htole32(nbt_image_crc32(builder->buffer + section->offset, section->length))};
+        memcpy(builder->buffer + sizeof(header) + (i * sizeof(encoded)), &encoded, sizeof(encoded));
+    }
+}
+
+/**
+ * \brief Reads file access policies and configurator settings into the image.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] builder Image builder.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_image_dump_settings(nbt_cmd_t *nbt, struct nbt_image_builder *builder)
+{
+    // File access policies
+    ifx_status_t status = nbt_select_nbt_application(nbt);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    nbt_file_access_policy_t faps[NBT_IMAGE_FAP_COUNT];
+    status = nbt_read_fap(nbt, faps);
+    ifx_apdu_destroy(nbt->apdu);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not read file access policies");
+        return status;
+    }
+    if (nbt->response->sw != 0x9000U)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid status word for reading file access policy: 0x%04X", nbt->response->sw);
+        ifx_apdu_response_destroy(nbt->response);
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_DUMP, IFX_SW_ERROR);
+    }
+    ifx_apdu_response_destroy(nbt->response);
+    struct nbt_image_section *section = nbt_image_add_section(builder, NBT_IMAGE_SECTION_FAP, NBT_FILEID_FAP, sizeof(faps) / sizeof(faps[0]) * NBT_IMAGE_FAP_ENTRY_SIZE);
+    uint8_t *entry = builder->buffer + section->offset;
+    for (size_t i = 0U; i < (sizeof(faps) / sizeof(faps[0])); i++)
+    {
+        entry[0] = (uint8_t) (faps[i].file_id >> 8);
+        entry[1] = (uint8_t) faps[i].file_id;
+        entry[2] = (uint8_t) faps[i].i2c_read_access_condition;
+        entry[3] = (uint8_t) faps[i].i2c_write_access_condition;
+        entry[4] = (uint8_t) faps[i].nfc_read_access_condition;
+        entry[5] = (uint8_t) faps[i].nfc_write_access_condition;
+        entry += NBT_IMAGE_FAP_ENTRY_SIZE;
+    }
+
+    // Configurator settings
+    status = nbt_select_configurator_application(nbt);
+    ifx_apdu_destroy(nbt->apdu);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not select NBT configurator application");
+        return status;
+    }
+    if (nbt->response->sw != 0x9000U)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid status word for selecting NBT configurator application: 0x%04X", nbt->response->sw);
+        ifx_apdu_response_destroy(nbt->response);
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_DUMP, IFX_SW_ERROR);
+    }
+    ifx_apdu_response_destroy(nbt->response);
+    section = nbt_image_add_section(builder, NBT_IMAGE_SECTION_CONFIG, 0x0000U, sizeof(NBT_IMAGE_CONFIG_TAGS) / sizeof(NBT_IMAGE_CONFIG_TAGS[0]) * 2U);
+    entry = builder->buffer + section->offset;
+    for (size_t i = 0U; i < (sizeof(NBT_IMAGE_CONFIG_TAGS) / sizeof(NBT_IMAGE_CONFIG_TAGS[0])); i++)
+    {
+        status = nbt_get_configuration(nbt, NBT_IMAGE_CONFIG_TAGS[i]);
+        ifx_apdu_destroy(nbt->apdu);
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not read configuration 0x%02X", NBT_IMAGE_CONFIG_TAGS[i]);
+            return status;
+        }
+        if (nbt->response->sw != 0x9000U)
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid response for reading configuration 0x%02X: 0x%04X", NBT_IMAGE_CONFIG_TAGS[i], nbt->response->sw);
+            ifx_apdu_response_destroy(nbt->response);
+            return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_DUMP, IFX_SW_ERROR);
+        }
+        entry[0] = (uint8_t) NBT_IMAGE_CONFIG_TAGS[i];
+        status = nbt_image_parse_config_value(NBT_IMAGE_CONFIG_TAGS[i], nbt->response->data, nbt->response->len, &entry[1]);
+        ifx_apdu_response_destroy(nbt->response);
+        if (ifx_error_check(status))
+        {
+            return status;
+        }
+        entry += 2U;
+    }
+
+    // Leave NBT application selected for subsequent jobs
+    return nbt_select_nbt_application(nbt);
+}
+
+/**
+ * \brief Reads all NBT files, file access policies and configurator settings into a newly allocated image.
+ *
+ * \details Leaves the NBT application selected.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[out] image Newly allocated image (to be freed with free()).
+ * \param[out] length Length of \c image in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_dump(nbt_cmd_t *nbt, uint8_t **image, size_t *length)
+{
+    if ((nbt == NULL) || (image == NULL) || (length == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_DUMP, IFX_ILLEGAL_ARGUMENT);
+    }
+    struct nbt_image_builder builder = {.length = sizeof(struct nbt_image_header) + (NBT_IMAGE_MAX_SECTIONS * sizeof(struct nbt_image_section))};
+    builder.buffer = (uint8_t *) calloc(1U, NBT_IMAGE_MAX_LENGTH);
+    if (builder.buffer == NULL)
+    {
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_DUMP, IFX_OUT_OF_MEMORY);
+    }
+
+    ifx_status_t status = nbt_select_nbt_application(nbt);
+    if (ifx_error_check(status))
+    {
+        goto cleanup;
+    }
+
+    // Capability container sizes the NDEF file
+    uint8_t cclen[2];
+    status = nbt_read_file(nbt, NBT_FILEID_CC, 0U, sizeof(cclen), cclen);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not read capability container");
+        goto cleanup;
+    }
+    size_t cc_length = (size_t) ((cclen[0] << 8) | cclen[1]);
+    if ((cc_length < sizeof(cclen)) || (cc_length > NBT_IMAGE_CC_MAX_SIZE))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid capability container length %u", (unsigned int) cc_length);
+        status = IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_DUMP, NBT_IMAGE_INVALID);
+        goto cleanup;
+    }
+    struct nbt_image_section *section = nbt_image_add_section(&builder, NBT_IMAGE_SECTION_FILE, NBT_FILEID_CC, cc_length);
+    const uint8_t *cc = builder.buffer + section->offset;
+    status = nbt_read_file(nbt, NBT_FILEID_CC, 0U, cc_length, builder.buffer + section->offset);
+    if (ifx_error_check(status))
+    {
+        goto cleanup;
+    }
+    size_t ndef_length = NBT_IMAGE_NDEF_FILE_SIZE;
+    if ((cc_length >= 15U) && (cc[7] == 0x04U))
+    {
+        // NDEF file control TLV: maximum NDEF file size
+        ndef_length = (size_t) ((cc[11] << 8) | cc[12]);
+        if ((ndef_length == 0U) || (ndef_length > NBT_IMAGE_NDEF_FILE_SIZE))
+        {
+            ndef_length = NBT_IMAGE_NDEF_FILE_SIZE;
+        }
+    }
+
+    // Files are read completely, nbt_read_file() splits them into maximum size READ BINARY commands
+    section = nbt_image_add_section(&builder, NBT_IMAGE_SECTION_FILE, NBT_FILEID_NDEF, ndef_length);
+    if (ifx_error_check(nbt_read_file(nbt, NBT_FILEID_NDEF, 0U, ndef_length, builder.buffer + section->offset)))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "NDEF file not readable, skipped");
+        nbt_image_drop_section(&builder, section);
+    }
+    for (size_t i = 0U; i < (sizeof(NBT_IMAGE_PROPRIETARY_FILES) / sizeof(NBT_IMAGE_PROPRIETARY_FILES[0])); i++)
+    {
+        section = nbt_image_add_section(&builder, NBT_IMAGE_SECTION_FILE, (uint16_t) NBT_IMAGE_PROPRIETARY_FILES[i], NBT_PROPRIETARY_FILE_SIZE);
+        if (ifx_error_check(nbt_read_file(nbt, NBT_IMAGE_PROPRIETARY_FILES[i], 0U, NBT_PROPRIETARY_FILE_SIZE, builder.buffer + section->offset)))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "File 0x%04X not readable, skipped", NBT_IMAGE_PROPRIETARY_FILES[i]);
+            nbt_image_drop_section(&builder, section);
+        }
+    }
+
+    status = nbt_image_dump_settings(nbt, &builder);
+    if (ifx_error_check(status))
+    {
+        goto cleanup;
+    }
+
+    // Move section data directly behind the actually used section table
+    size_t table_end = sizeof(struct nbt_image_header) + (builder.section_count * sizeof(struct nbt_image_section));
+    size_t data_start = (table_end + NBT_IMAGE_ALIGNMENT - 1U) & ~((size_t) NBT_IMAGE_ALIGNMENT - 1U);
+    size_t reserved_end = sizeof(struct nbt_image_header) + (NBT_IMAGE_MAX_SECTIONS * sizeof(struct nbt_image_section));
+    memmove(builder.buffer + data_start, builder.buffer + reserved_end, builder.length - reserved_end);
+    for (uint16_t i = 0U; i < builder.section_count; i++)
+    {
+        builder.sections[i].offset -= (uint32_t) (reserved_end - data_start);
+    }
+    builder.length -= reserved_end - data_start;
+    nbt_image_finish(&builder);
+
+    *image = builder.buffer;
+    *length = builder.length;
+    ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "Dumped %u sections into %u byte image", builder.section_count, (unsigned int) builder.length);
+    return IFX_SUCCESS;
+
+cleanup:
+    free(builder.buffer);
+    return status;
+}
+
+/**
+ * \brief Checks image header, section table bounds and section checksums.
+ *
+ * \param[in] image Image to be checked.
+ * \param[in] length Length of \c image in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if image is valid, any other value in case of error.
+ */
+ifx_status_t nbt_image_validate(const uint8_t *image, size_t length)
+{
+    if ((image == NULL) || (length < sizeof(struct nbt_image_header)))
+    {
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_VALIDATE, IFX_ILLEGAL_ARGUMENT);
+    }
+    const struct nbt_image_header *header = (const struct nbt_image_header *) image;
+    uint16_t section_count = le16toh(header->section_count);
+    if ((memcmp(header->magic, NBT_IMAGE_MAGIC, sizeof(header->magic)) != 0) || (le16toh(header->version) != NBT_IMAGE_VERSION) ||
+        (le32toh(header->length) != length) || (section_count > NBT_IMAGE_MAX_SECTIONS) ||
+        ((sizeof(struct nbt_image_header) + (section_count * sizeof(struct nbt_image_section))) > length))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid image header");
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_VALIDATE, NBT_IMAGE_INVALID);
+    }
+    const struct nbt_image_section *sections = (const struct nbt_image_section *) (image + sizeof(struct nbt_image_header));
+    for (uint16_t i = 0U; i < section_count; i++)
+    {
+        size_t offset = le32toh(sections[i].offset);
+        size_t section_length = le32toh(sections[i].length);
+        if ((offset > length) || (section_length > (length - offset)) || (section_length > NBT_IMAGE_NDEF_FILE_SIZE) ||
+            (nbt_image_crc32(image + offset, section_length) != le32toh(sections[i].crc32)))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid image section 0x%04X", le16toh(sections[i].id));
+            return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_VALIDATE, NBT_IMAGE_INVALID);
+        }
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Looks up section in a validated image.
+ *
+ * \param[in] image Validated image.
+ * \param[in] kind Section kind.
+ * \param[in] id Section identifier.
+ * \return const struct nbt_image_section * Section table entry or \c NULL if not found.
+ */
+const struct nbt_image_section *nbt_image_find_section(const uint8_t *image, enum nbt_image_section_kind kind, uint16_t id)
+{
+    const struct nbt_image_header *header = (const struct nbt_image_header *) image;
+    const struct nbt_image_section *sections = (const struct nbt_image_section *) (image + sizeof(struct nbt_image_header));
+    for (uint16_t i = 0U; i < le16toh(header->section_count); i++)
+    {
+        if ((sections[i].kind == (uint8_t) kind) && (le16toh(sections[i].id) == id))
+        {
+            return &sections[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief Restores a single file section writing only differing regions.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] image Validated image.
+ * \param[in] section File section to be restored.
+ * \param[in,out] stats Restore statistics.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_image_restore_file(nbt_cmd_t *nbt, const uint8_t *image, const struct nbt_image_section *section,
+                                           struct nbt_image_restore_stats *stats)
+{
+    enum nbt_fileid file_id = (enum nbt_fileid) le16toh(section->id);
+    const uint8_t *data = image + le32toh(section->offset);
+    size_t length = le32toh(section->length);
+    if ((section->flags & NBT_IMAGE_FLAG_UNREADABLE) != 0U)
+    {
+        stats->skipped++;
+        return IFX_SUCCESS;
+    }
+
+    uint8_t current[NBT_IMAGE_NDEF_FILE_SIZE];
+    ifx_status_t status = nbt_read_file(nbt, file_id, 0U, length, current);
+    if (file_id == NBT_FILEID_CC)
+    {
+        // Capability container is read-only, only report mismatches
+        if (!ifx_error_check(status) && (memcmp(current, data, length) != 0))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Capability container differs from image");
+        }
+        stats->compared += length;
+        stats->skipped++;
+        return IFX_SUCCESS;
+    }
+    if (ifx_error_check(status))
+    {
+        // Not readable over I2C, fall back to writing the complete file
+        status = nbt_write_file(nbt, file_id, 0U, data, length);
+        if (!ifx_error_check(status))
+        {
+            stats->written += length;
+        }
+        return status;
+    }
+    size_t written = 0U;
+    status = nbt_write_file_differences(nbt, file_id, 0U, current, data, length, &written);
+    stats->compared += length;
+    stats->written += written;
+    return status;
+}
+
+/**
+ * \brief Restores image onto NBT, writing only the file regions that differ from the image.
+ *
+ * \details File access policies of the image that allow I2C writes are applied before the files are written, so files
+ * locked on the tag but writable in the image can be restored. Policies that forbid I2C writes and the configurator
+ * settings are applied after the files, so the image cannot lock out its own files. Files that are locked for I2C writes
+ * both on the tag and in the image cannot be restored (as well as any policy if the tag locks the FAP file itself). The
+ * capability container is only compared.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] image Image to be restored (e.g. as returned by nbt_image_load()).
+ * \param[in] length Length of \c image in bytes.
+ * \param[out] stats Optional, restore statistics.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_restore(nbt_cmd_t *nbt, const uint8_t *image, size_t length, struct nbt_image_restore_stats *stats)
+{
+    if (nbt == NULL)
+    {
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_RESTORE, IFX_ILLEGAL_ARGUMENT);
+    }
+    ifx_status_t status = nbt_image_validate(image, length);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    struct nbt_image_restore_stats local_stats = {0};
+    if (stats == NULL)
+    {
+        stats = &local_stats;
+    }
+    memset(stats, 0, sizeof(struct nbt_image_restore_stats));
+
+    // File access policies and configurator settings
+    const struct nbt_image_section *fap_section = nbt_image_find_section(image, NBT_IMAGE_SECTION_FAP, NBT_FILEID_FAP);
+    const struct nbt_image_section *config_section = nbt_image_find_section(image, NBT_IMAGE_SECTION_CONFIG, 0x0000U);
+    bool settings = (fap_section != NULL) && (config_section != NULL);
+    nbt_file_access_policy_t faps[NBT_IMAGE_FAP_COUNT];
+    nbt_file_access_policy_t *fap_pointers[NBT_IMAGE_FAP_COUNT];
+    nbt_file_access_policy_t *writable_faps[NBT_IMAGE_FAP_COUNT];
+    size_t writable_faps_len = 0U;
+    struct nbt_configuration configuration = {.fap = fap_pointers,
+                                              .fap_len = 0U,
+                                              .communication_interface = NBT_COMM_INTF_NFC_ENABLED_I2C_ENABLED,
+                                              .irq_function = NBT_GPIO_FUNCTION_DISABLED};
+    if (settings)
+    {
+        const uint8_t *entry = image + le32toh(fap_section->offset);
+        for (size_t i = 0U; (i < NBT_IMAGE_FAP_COUNT) && (((i + 1U) * NBT_IMAGE_FAP_ENTRY_SIZE) <= le32toh(fap_section->length)); i++)
+        {
+            memset(&faps[i], 0, sizeof(nbt_file_access_policy_t));
+            faps[i].file_id = (uint16_t) ((entry[0] << 8) | entry[1]);
+            faps[i].i2c_read_access_condition = (nbt_access_conditions) entry[2];
+            faps[i].i2c_write_access_condition = (nbt_access_conditions) entry[3];
+            faps[i].nfc_read_access_condition = (nbt_access_conditions) entry[4];
+            faps[i].nfc_write_access_condition = (nbt_access_conditions) entry[5];
+            fap_pointers[i] = &faps[i];
+            configuration.fap_len++;
+            if (faps[i].i2c_write_access_condition == NBT_ACCESS_ALWAYS)
+            {
+                writable_faps[writable_faps_len++] = &faps[i];
+            }
+            entry += NBT_IMAGE_FAP_ENTRY_SIZE;
+        }
+        entry = image + le32toh(config_section->offset);
+        for (size_t i = 0U; (i + 2U) <= le32toh(config_section->length); i += 2U)
+        {
+            if (entry[i] == (uint8_t) NBT_TAG_COMMUNICATION_INTERFACE_ENABLE)
+            {
+                configuration.communication_interface = (nbt_communication_interface_tags) entry[i + 1U];
+            }
+            else if (entry[i] == (uint8_t) NBT_TAG_GPIO_FUNCTION)
+            {
+                configuration.irq_function = (nbt_gpio_function_tags) entry[i + 1U];
+            }
+        }
+
+        // Unlock files that are writable over I2C in the image before writing them (leaves NBT application selected)
+        status = nbt_update_file_access_policies(nbt, writable_faps, writable_faps_len);
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not apply file access policies of the image before restoring files");
+            return status;
+        }
+    }
+    else
+    {
+        status = nbt_select_nbt_application(nbt);
+        if (ifx_error_check(status))
+        {
+            return status;
+        }
+    }
+
+    // File contents
+    const struct nbt_image_header *header = (const struct nbt_image_header *) image;
+    const struct nbt_image_section *sections = (const struct nbt_image_section *) (image + sizeof(struct nbt_image_header));
+    for (uint16_t i = 0U; i < le16toh(header->section_count); i++)
+    {
+        if (sections[i].kind != NBT_IMAGE_SECTION_FILE)
+        {
+            continue;
+        }
+        status = nbt_image_restore_file(nbt, image, &sections[i], stats);
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not restore file 0x%04X", le16toh(sections[i].id));
+            return status;
+        }
+    }
+
+    // Remaining (restrictive) file access policies and configurator settings, unchanged policies are skipped but both
+    // configurator settings are always sent
+    if (!settings)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Image contains no settings, file access policies and configuration unchanged");
+        return IFX_SUCCESS;
+    }
+    status = nbt_configure(nbt, &configuration);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not restore file access policies and configuration");
+        return status;
+    }
+    return nbt_select_nbt_application(nbt);
+}
+
+/**
+ * \brief Writes image to file.
+ *
+ * \details Images contain all proprietary files, so new files are created with mode \c 0600 and existing ones are
+ * restricted to the owner before they are overwritten.
+ *
+ * \param[in] path Destination file.
+ * \param[in] image Image to be written.
+ * \param[in] length Length of \c image in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_save(const char *path, const uint8_t *image, size_t length)
+{
+    if ((path == NULL) || (image == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_FILE, IFX_ILLEGAL_ARGUMENT);
+    }
+    int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not open image file %s", path);
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_FILE, IFX_UNSPECIFIED_ERROR);
+    }
+    // The creation mode does not apply to existing files
+    struct stat file_stat;
+    FILE *file = NULL;
+    if ((fstat(fd, &file_stat) != 0) || (((file_stat.st_mode & (S_IRWXG | S_IRWXO)) != 0U) && (fchmod(fd, S_IRUSR | S_IWUSR) != 0)) ||
+        ((file = fdopen(fd, "wb")) == NULL))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not open image file %s", path);
+        close(fd);
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_FILE, IFX_UNSPECIFIED_ERROR);
+    }
+    size_t written = fwrite(image, 1U, length, file);
+    if ((fclose(file) != 0) || (written != length))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not write image file %s", path);
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_FILE, IFX_UNSPECIFIED_ERROR);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Maps file read-only into memory.
+ *
+ * \param[in] path File to be mapped.
+ * \param[in] function IFX error encoding function identifier of caller.
+ * \param[out] mapping Mapped file.
+ * \param[out] length Length of \c mapping in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_image_map_file(const char *path, uint8_t function, const uint8_t **mapping, size_t *length)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not open %s", path);
+        return IFX_ERROR(LIB_NBT_IMAGE, function, IFX_UNSPECIFIED_ERROR);
+    }
+    struct stat file_stat;
+    if ((fstat(fd, &file_stat) != 0) || (file_stat.st_size <= 0))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid file %s", path);
+        close(fd);
+        return IFX_ERROR(LIB_NBT_IMAGE, function, NBT_IMAGE_INVALID);
+    }
+    void *file_mapping = mmap(NULL, (size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file_mapping == MAP_FAILED)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not map %s", path);
+        return IFX_ERROR(LIB_NBT_IMAGE, function, IFX_UNSPECIFIED_ERROR);
+    }
+    *mapping = (const uint8_t *) file_mapping;
+    *length = (size_t) file_stat.st_size;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Maps image file read-only into memory and validates it.
+ *
+ * \param[in] path Image file.
+ * \param[out] image Mapped image (to be released with nbt_image_unload()).
+ * \param[out] length Length of \c image in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_load(const char *path, const uint8_t **image, size_t *length)
+{
+    if ((path == NULL) || (image == NULL) || (length == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_FILE, IFX_ILLEGAL_ARGUMENT);
+    }
+    const uint8_t *mapping = NULL;
+    size_t mapping_length = 0U;
+    ifx_status_t status = nbt_image_map_file(path, NBT_IMAGE_FILE, &mapping, &mapping_length);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    status = nbt_image_validate(mapping, mapping_length);
+    if (ifx_error_check(status))
+    {
+        munmap((void *) mapping, mapping_length);
+        return status;
+    }
+    *image = mapping;
+    *length = mapping_length;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Releases image mapped by nbt_image_load().
+ *
+ * \param[in] image Mapped image.
+ * \param[in] length Length of \c image in bytes.
+ */
+void nbt_image_unload(const uint8_t *image, size_t length)
+{
+    if (image != NULL)
+    {
+        munmap((void *) image, length);
+    }
+}
+
+/**
+ * \brief Maps image pack read-only into memory and validates its index.
+ *
+ * \param[in] self Image pack.
+ * \param[in] path Image pack file.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_pack_open(struct nbt_image_pack *self, const char *path)
+{
+    if ((self == NULL) || (path == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_PACK, IFX_ILLEGAL_ARGUMENT);
+    }
+    memset(self, 0, sizeof(struct nbt_image_pack));
+    ifx_status_t status = nbt_image_map_file(path, NBT_IMAGE_PACK, &self->mapping, &self->length);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+
+    // Check header and bounds of all entries once, so that lookups only need to check the message checksum
+    const struct nbt_image_pack_header *header = (const struct nbt_image_pack_header *) self->mapping;
+    bool valid = (self->length >= sizeof(struct nbt_image_pack_header)) &&
+                 (memcmp(header->magic, NBT_IMAGE_PACK_MAGIC, sizeof(header->magic)) == 0) &&
+                 (le16toh(header->version) == NBT_IMAGE_PACK_VERSION) && (le16toh(header->entry_size) == sizeof(struct nbt_image_pack_entry)) &&
+                 (le32toh(header->length) == self->length) && ((le32toh(header->index_offset) % sizeof(uint32_t)) == 0U) &&
+                 (le32toh(header->index_offset) <= self->length) &&
+                 (le32toh(header->count) <= ((self->length - le32toh(header->index_offset)) / sizeof(struct nbt_image_pack_entry)));
+    if (valid)
+    {
+        self->entries = (const struct nbt_image_pack_entry *) (self->mapping + le32toh(header->index_offset));
+        self->count = le32toh(header->count);
+        for (uint32_t i = 0U; valid && (i < self->count); i++)
+        {
+            size_t offset = le32toh(self->entries[i].offset);
+            size_t length = le32toh(self->entries[i].length);
+            valid = (offset <= self->length) && (length <= (self->length - offset)) && (length <= NBT_IMAGE_NDEF_FILE_SIZE) &&
+                    ((i == 0U) || (memcmp(self->entries[i - 1U].device_id, self->entries[i].device_id, NBT_IMAGE_PACK_DEVICE_ID_SIZE) < 0));
+        }
+    }
+    if (!valid)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid image pack %s", path);
+        nbt_image_pack_close(self);
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_PACK, NBT_IMAGE_INVALID);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Looks up NDEF message of a device in an image pack.
+ *
+ * \param[in] self Image pack.
+ * \param[in] device_id Device ID.
+ * \param[out] message NDEF message (including NLEN) within the mapped pack.
+ * \param[out] length Length of \c message in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_pack_find(const struct nbt_image_pack *self, const char *device_id, const uint8_t **message, size_t *length)
+{
+    if ((self == NULL) || (self->mapping == NULL) || (device_id == NULL) || (message == NULL) || (length == NULL) ||
+        (strlen(device_id) > NBT_IMAGE_PACK_DEVICE_ID_SIZE))
+    {
+        return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_PACK, IFX_ILLEGAL_ARGUMENT);
+    }
+    uint8_t key[NBT_IMAGE_PACK_DEVICE_ID_SIZE] = {0};
+    memcpy(key, device_id, strlen(device_id));
+
+    // Binary search in sorted index
+    uint32_t low = 0U;
+    uint32_t high = self->count;
+    while (low < high)
+    {
+        uint32_t middle = low + ((high - low) / 2U);
+        const struct nbt_image_pack_entry *entry = &self->entries[middle];
+        int order = memcmp(entry->device_id, key, sizeof(key));
+        if (order < 0)
+        {
+            low = middle + 1U;
+        }
+        else if (order > 0)
+        {
+            high = middle;
+        }
+        else
+        {
+            const uint8_t *data = self->mapping + le32toh(entry->offset);
+            size_t data_length = le32toh(entry->length);
+            if (nbt_image_crc32(data, data_length) != le32toh(entry->crc32))
+            {
+                ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Corrupted image pack entry for device %s", device_id);
+                return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_PACK, NBT_IMAGE_INVALID);
+            }
+            *message = data;
+            *length = data_length;
+            return IFX_SUCCESS;
+        }
+    }
+    ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Device %s not found in image pack", device_id);
+    return IFX_ERROR(LIB_NBT_IMAGE, NBT_IMAGE_PACK, NBT_IMAGE_NOT_FOUND);
+}
+
+/**
+ * \brief Releases image pack mapped by nbt_image_pack_open().
+ *
+ * \param[in] self Image pack.
+ */
+void nbt_image_pack_close(struct nbt_image_pack *self)
+{
+    if ((self != NULL) && (self->mapping != NULL))
+    {
+        munmap((void *) self->mapping, self->length);
+        memset(self, 0, sizeof(struct nbt_image_pack));
+    }
+}
+
+/**
+ * \brief Scheduler job dumping the tag into an image file.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] context Path of image file to be written (\c const \c char *).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_dump_job(nbt_cmd_t *nbt, void *context)
+{
+    const char *path = (const char *) context;
+    uint8_t *image = NULL;
+    size_t length = 0U;
+    ifx_status_t status = nbt_image_dump(nbt, &image, &length);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    status = nbt_image_save(path, image, length);
+    free(image);
+    return status;
+}
+
+/**
+ * \brief Scheduler job restoring an image file onto the tag.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] context Path of image file to be restored (\c const \c char *).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_restore_job(nbt_cmd_t *nbt, void *context)
+{
+    const char *path = (const char *) context;
+    const uint8_t *image = NULL;
+    size_t length = 0U;
+    ifx_status_t status = nbt_image_load(path, &image, &length);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    struct nbt_image_restore_stats stats;
+    status = nbt_image_restore(nbt, image, length, &stats);
+    nbt_image_unload(image, length);
+    if (!ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "Restored %s: %u of %u bytes written, %u sections skipped", path,
+                       (unsigned int) stats.written, (unsigned int) stats.compared, (unsigned int) stats.skipped);
+    }
+    return status;
+}
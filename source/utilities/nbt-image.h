@@ -0,0 +1,483 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-image.h
+ * \brief Snapshot and restore of a complete NBT tag in a compact binary image.
+ *
+ * \details Layout of an image (all integers little endian, all structures naturally aligned so that an mmapped image
+ * can be inspected through struct nbt_image_header and struct nbt_image_section on little endian hosts):
+ *
+ *   | Offset          | Size      | Content                                                         |
+ *   | --------------- | --------- | --------------------------------------------------------------- |
+ *   | 0               | 16        | struct nbt_image_header                                         |
+ *   | 16 + n * 16     | 16        | struct nbt_image_section \c n                                   |
+ *   | section offset  | length    | Section data (each section starts at a 16 byte boundary)        |
+ *
+ * Section contents:
+ *
+ *   | Kind                           | Identifier | Data                                                  |
+ *   | ------------------------------ | ---------- | ----------------------------------------------------- |
+ *   | \c NBT_IMAGE_SECTION_FILE      | File ID    | Raw file contents                                     |
+ *   | \c NBT_IMAGE_SECTION_FAP       | 0xE1AF     | 6 bytes per file: file ID (big endian), I2C read, I2C |
+ *   |                                |            | write, NFC read, NFC write access condition           |
+ *   | \c NBT_IMAGE_SECTION_CONFIG    | 0x0000     | 2 bytes per setting: configurator tag, value          |
+ *
+ * Files that could not be read (e.g. access condition \c NBT_ACCESS_NEVER over I2C) are kept as empty sections with
+ * \c NBT_IMAGE_FLAG_UNREADABLE set.
+ *
+ * Image packs (created by \c scripts/create_NDEF_batch.py) hold one pre-encoded NDEF message per device, so that
+ * provisioning only needs a lookup by device ID:
+ *
+ *   | Offset          | Size      | Content                                                         |
+ *   | --------------- | --------- | --------------------------------------------------------------- |
+ *   | 0               | 32        | struct nbt_image_pack_header                                    |
+ *   | index offset    | 48 * n    | struct nbt_image_pack_entry, sorted by device ID                |
+ *   | entry offset    | length    | NDEF message including NLEN (each starts at a 16 byte boundary) |
+ */
+#ifndef NBT_IMAGE_H
+#define NBT_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/nbt-cmd.h"
+
+#include "nbt-utilities.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Identifier for the tag image used in error codes.
+ */
+#define LIB_NBT_IMAGE 0x65U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_image_dump().
+ */
+#define NBT_IMAGE_DUMP 0x01U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_image_restore().
+ */
+#define NBT_IMAGE_RESTORE 0x02U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_image_validate().
+ */
+#define NBT_IMAGE_VALIDATE 0x03U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_image_save() and nbt_image_load().
+ */
+#define NBT_IMAGE_FILE 0x04U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_image_pack_open() and nbt_image_pack_find().
+ */
+#define NBT_IMAGE_PACK 0x05U
+
+/**
+ * \brief Error reason if an image is malformed or of an unsupported version.
+ */
+#define NBT_IMAGE_INVALID 0x20U
+
+/**
+ * \brief Error reason if a device ID is not contained in an image pack.
+ */
+#define NBT_IMAGE_NOT_FOUND 0x21U
+
+/**
+ * \brief Magic bytes at the start of every image.
+ */
+#define NBT_IMAGE_MAGIC "NBTI"
+
+/**
+ * \brief Current image format version.
+ */
+#define NBT_IMAGE_VERSION 1U
+
+/**
+ * \brief Magic bytes at the start of every image pack.
+ */
+#define NBT_IMAGE_PACK_MAGIC "NBTP"
+
+/**
+ * \brief Current image pack format version.
+ */
+#define NBT_IMAGE_PACK_VERSION 1U
+
+/**
+ * \brief Size of the (NUL padded) device ID of an image pack entry.
+ */
+#define NBT_IMAGE_PACK_DEVICE_ID_SIZE 32U
+
+/**
+ * \brief Alignment of section data within an image.
+ */
+#define NBT_IMAGE_ALIGNMENT 16U
+
+/**
+ * \brief Maximum number of sections in an image.
+ */
+#define NBT_IMAGE_MAX_SECTIONS 16U
+
+/**
+ * \brief Size of an NBT NDEF file in bytes (used if the capability container does not state a maximum size).
+ */
+#define NBT_IMAGE_NDEF_FILE_SIZE 4096U
+
+/**
+ * \brief Number of file access policies of an NBT (one per file).
+ */
+#define NBT_IMAGE_FAP_COUNT 7U
+
+/**
+ * \brief Set in nbt_image_section.flags if the section could not be read during the dump.
+ */
+#define NBT_IMAGE_FLAG_UNREADABLE 0x01U
+
+/** \enum nbt_image_section_kind
+ * \brief Kinds of image sections.
+ */
+enum nbt_image_section_kind
+{
+    /**
+     * \brief Contents of an NBT file (identifier is the file ID).
+     */
+    NBT_IMAGE_SECTION_FILE = 0x01U,
+
+    /**
+     * \brief File access policies of all NBT files.
+     */
+    NBT_IMAGE_SECTION_FAP = 0x02U,
+
+    /**
+     * \brief Configurator application settings.
+     */
+    NBT_IMAGE_SECTION_CONFIG = 0x03U
+};
+
+/** \struct nbt_image_header
+ * \brief Image header as stored at offset 0.
+ */
+struct nbt_image_header
+{
+    /**
+     * \brief Magic bytes \c NBT_IMAGE_MAGIC.
+     */
+    uint8_t magic[4];
+
+    /**
+     * \brief Image format version (\c NBT_IMAGE_VERSION).
+     */
+    uint16_t version;
+
+    /**
+     * \brief Number of entries in the section table following the header.
+     */
+    uint16_t section_count;
+
+    /**
+     * \brief Total image length in bytes.
+     */
+    uint32_t length;
+
+    /**
+     * \brief Time of the dump (seconds since epoch).
+     */
+    uint32_t timestamp;
+};
+
+/** \struct nbt_image_section
+ * \brief Section table entry.
+ */
+struct nbt_image_section
+{
+    /**
+     * \brief Identifier (file ID for file sections).
+     */
+    uint16_t id;
+
+    /**
+     * \brief Section kind (\c enum nbt_image_section_kind).
+     */
+    uint8_t kind;
+
+    /**
+     * \brief Section flags (e.g. \c NBT_IMAGE_FLAG_UNREADABLE).
+     */
+    uint8_t flags;
+
+    /**
+     * \brief Offset of section data from start of image.
+     */
+    uint32_t offset;
+
+    /**
+     * \brief Length of section data in bytes.
+     */
+    uint32_t length;
+
+    /**
+     * \brief CRC-32 (ISO-HDLC) over section data.
+     */
+    uint32_t crc32;
+};
+
+/** \struct nbt_image_pack_header
+ * \brief Image pack header as stored at offset 0.
+ */
+struct nbt_image_pack_header
+{
+    /**
+     * \brief Magic bytes \c NBT_IMAGE_PACK_MAGIC.
+     */
+    uint8_t magic[4];
+
+    /**
+     * \brief Image pack format version (\c NBT_IMAGE_PACK_VERSION).
+     */
+    uint16_t version;
+
+    /**
+     * \brief Size of an index entry (sizeof(struct nbt_image_pack_entry)).
+     */
+    uint16_t entry_size;
+
+    /**
+     * \brief Number of index entries.
+     */
+    uint32_t count;
+
+    /**
+     * \brief Offset of first index entry.
+     */
+    uint32_t index_offset;
+
+    /**
+     * \brief Offset of first message.
+     */
+    uint32_t data_offset;
+
+    /**
+     * \brief Total pack length in bytes.
+     */
+    uint32_t length;
+
+    /**
+     * \brief Reserved (0x00).
+     */
+    uint8_t reserved[8];
+};
+
+/** \struct nbt_image_pack_entry
+ * \brief Image pack index entry.
+ */
+struct nbt_image_pack_entry
+{
+    /**
+     * \brief Device ID (NUL padded).
+     */
+    uint8_t device_id[NBT_IMAGE_PACK_DEVICE_ID_SIZE];
+
+    /**
+     * \brief Offset of NDEF message from start of pack.
+     */
+    uint32_t offset;
+
+    /**
+     * \brief Length of NDEF message (including NLEN) in bytes.
+     */
+    uint32_t length;
+
+    /**
+     * \brief CRC-32 (ISO-HDLC) over NDEF message.
+     */
+    uint32_t crc32;
+
+    /**
+     * \brief Reserved (0x00).
+     */
+    uint32_t reserved;
+};
+
+/** \struct nbt_image_pack
+ * \brief Image pack mapped into memory.
+ */
+struct nbt_image_pack
+{
+    /**
+     * \brief Mapped pack file.
+     */
+    const uint8_t *mapping;
+
+    /**
+     * \brief Length of nbt_image_pack.mapping in bytes.
+     */
+    size_t length;
+
+    /**
+     * \brief Index entries (sorted by device ID).
+     */
+    const struct nbt_image_pack_entry *entries;
+
+    /**
+     * \brief Number of index entries.
+     */
+    uint32_t count;
+};
+
+/** \struct nbt_image_restore_stats
+ * \brief Statistics of a restore.
+ */
+struct nbt_image_restore_stats
+{
+    /**
+     * \brief Number of file bytes compared against the image.
+     */
+    size_t compared;
+
+    /**
+     * \brief Number of file bytes actually written.
+     */
+    size_t written;
+
+    /**
+     * \brief Number of file sections skipped (unreadable in image or read-only on tag).
+     */
+    size_t skipped;
+};
+
+/**
+ * \brief Reads all NBT files, file access policies and configurator settings into a newly allocated image.
+ *
+ * \details Leaves the NBT application selected.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[out] image Newly allocated image (to be freed with free()).
+ * \param[out] length Length of \c image in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_dump(nbt_cmd_t *nbt, uint8_t **image, size_t *length);
+
+/**
+ * \brief Restores image onto NBT, writing only the file regions that differ from the image.
+ *
+ * \details File access policies of the image that allow I2C writes are applied before the files are written, so files
+ * locked on the tag but writable in the image can be restored. Policies that forbid I2C writes and the configurator
+ * settings are applied after the files, so the image cannot lock out its own files. Files that are locked for I2C writes
+ * both on the tag and in the image cannot be restored (as well as any policy if the tag locks the FAP file itself). The
+ * capability container is only compared.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] image Image to be restored (e.g. as returned by nbt_image_load()).
+ * \param[in] length Length of \c image in bytes.
+ * \param[out] stats Optional, restore statistics.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_restore(nbt_cmd_t *nbt, const uint8_t *image, size_t length, struct nbt_image_restore_stats *stats);
+
+/**
+ * \brief Checks image header, section table bounds and section checksums.
+ *
+ * \param[in] image Image to be checked.
+ * \param[in] length Length of \c image in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if image is valid, any other value in case of error.
+ */
+ifx_status_t nbt_image_validate(const uint8_t *image, size_t length);
+
+/**
+ * \brief Looks up section in a validated image.
+ *
+ * \param[in] image Validated image.
+ * \param[in] kind Section kind.
+ * \param[in] id Section identifier.
+ * \return const struct nbt_image_section * Section table entry or \c NULL if not found.
+ */
+const struct nbt_image_section *nbt_image_find_section(const uint8_t *image, enum nbt_image_section_kind kind, uint16_t id);
+
+/**
+ * \brief Writes image to file.
+ *
+ * \details Images contain all proprietary files, so new files are created with mode \c 0600 and existing ones are
+ * restricted to the owner before they are overwritten.
+ *
+ * \param[in] path Destination file.
+ * \param[in] image Image to be written.
+ * \param[in] length Length of \c image in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_save(const char *path, const uint8_t *image, size_t length);
+
+/**
+ * \brief Maps image file read-only into memory and validates it.
+ *
+ * \param[in] path Image file.
+ * \param[out] image Mapped image (to be released with nbt_image_unload()).
+ * \param[out] length Length of \c image in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_load(const char *path, const uint8_t **image, size_t *length);
+
+/**
+ * \brief Releases image mapped by nbt_image_load().
+ *
+ * \param[in] image Mapped image.
+ * \param[in] length Length of \c image in bytes.
+ */
+void nbt_image_unload(const uint8_t *image, size_t length);
+
+/**
+ * \brief Maps image pack read-only into memory and validates its index.
+ *
+ * \param[in] self Image pack.
+ * \param[in] path Image pack file.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_pack_open(struct nbt_image_pack *self, const char *path);
+
+/**
+ * \brief Looks up NDEF message of a device in an image pack.
+ *
+ * \param[in] self Image pack.
+ * \param[in] device_id Device ID.
+ * \param[out] message NDEF message (including NLEN) within the mapped pack.
+ * \param[out] length Length of \c message in bytes.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_pack_find(const struct nbt_image_pack *self, const char *device_id, const uint8_t **message, size_t *length);
+
+/**
+ * \brief Releases image pack mapped by nbt_image_pack_open().
+ *
+ * \param[in] self Image pack.
+ */
+void nbt_image_pack_close(struct nbt_image_pack *self);
+
+/**
+ * \brief Scheduler job dumping the tag into an image file.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] context Path of image file to be written (\c const \c char *).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_dump_job(nbt_cmd_t *nbt, void *context);
+
+/**
+ * \brief Scheduler job restoring an image file onto the tag.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] context Path of image file to be restored (\c const \c char *).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_image_restore_job(nbt_cmd_t *nbt, void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NBT_IMAGE_H
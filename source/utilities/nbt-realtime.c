@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-realtime.c
+ * \brief Real-time setup of the NBT I/O thread.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-logger.h"
+
+#include "nbt-realtime.h"
+
+/**
+ * \brief String used as source information for logging.
+ */
+#define LOG_TAG "NBT realtime"
+
+/**
+ * \brief Touches every page of a stack area below the caller's frame.
+ *
+ * \param[in] size Number of bytes to be touched.
+ * \param[in] page_size System page size.
+ */
+static __attribute__((noinline)) void nbt_realtime_prefault_stack(size_t size, size_t page_size)
+{
+    volatile uint8_t stack[size];
+    for (size_t i = 0U; i < size; i += page_size)
+    {
+        stack[i] = 0U;
+    }
+    (void) stack;
+}
+
+/**
+ * \brief Locks memory, prefaults stack and heap, pins and switches the calling thread to \c SCHED_FIFO.
+ *
+ * \details Signature matches nbt_scheduler_thread_hook_t so that it can be set as nbt_scheduler.thread_hook. Memory is
+ * unlocked again with \c munlockall() if any step after locking fails.
+ *
+ * \param[in] context Real-time settings (\c const struct nbt_realtime_config *).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_realtime_thread_hook(void *context)
+{
+    const struct nbt_realtime_config *config = (const struct nbt_realtime_config *) context;
+    if (config == NULL)
+    {
+        return IFX_ERROR(LIB_NBT_REALTIME, NBT_REALTIME_THREAD_HOOK, IFX_ILLEGAL_ARGUMENT);
+    }
+    int priority = (config->priority != 0) ? config->priority : NBT_REALTIME_DEFAULT_PRIORITY;
+    size_t stack_prefault = (config->stack_prefault != 0U) ? config->stack_prefault : NBT_REALTIME_DEFAULT_STACK_PREFAULT;
+    size_t heap_prefault = (config->heap_prefault != 0U) ? config->heap_prefault : NBT_REALTIME_DEFAULT_HEAP_PREFAULT;
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    if ((priority < sched_get_priority_min(SCHED_FIFO)) || (priority > sched_get_priority_max(SCHED_FIFO)) || (config->cpu < NBT_REALTIME_NO_CPU) ||
+        (config->cpu >= CPU_SETSIZE))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid SCHED_FIFO priority %d or CPU %d", priority, config->cpu);
+        return IFX_ERROR(LIB_NBT_REALTIME, NBT_REALTIME_THREAD_HOOK, IFX_ILLEGAL_ARGUMENT);
+    }
+
+    // Lock all current and future mappings so that nothing is paged out or faulted in lazily (unlocked again if any of
+    // the following steps fails, so that a failed setup does not leave the whole process locked)
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not lock memory: %s (CAP_IPC_LOCK / RLIMIT_MEMLOCK)", strerror(errno));
+        return IFX_ERROR(LIB_NBT_REALTIME, NBT_REALTIME_THREAD_HOOK, IFX_UNSPECIFIED_ERROR);
+    }
+
+    // Keep freed heap memory instead of returning it to the system and serve all allocations from the heap
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    // Prefault heap pool (in this thread's arena) and stack
+    uint8_t *pool = (uint8_t *) malloc(heap_prefault);
+    if (pool == NULL)
+    {
+        munlockall();
+        return IFX_ERROR(LIB_NBT_REALTIME, NBT_REALTIME_THREAD_HOOK, IFX_OUT_OF_MEMORY);
+    }
+    for (size_t i = 0U; i < heap_prefault; i += page_size)
+    {
+        ((volatile uint8_t *) pool)[i] = 0U;
+    }
+    free(pool);
+    nbt_realtime_prefault_stack(stack_prefault, page_size);
+
+    // Pin to core
+    if (config->cpu != NBT_REALTIME_NO_CPU)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(config->cpu, &cpus);
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error != 0)
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not pin I/O thread to CPU %d: %s", config->cpu, strerror(error));
+            munlockall();
+            return IFX_ERROR(LIB_NBT_REALTIME, NBT_REALTIME_THREAD_HOOK, IFX_ILLEGAL_ARGUMENT);
+        }
+    }
+
+    // Switch to real-time scheduling last, so that the preparation above does not delay other real-time work
+    struct sched_param parameters = {.sched_priority = priority};
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+    if (error != 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not set SCHED_FIFO priority %d: %s (CAP_SYS_NICE / RLIMIT_RTPRIO)", priority,
+                       strerror(error));
+        munlockall();
+        return IFX_ERROR(LIB_NBT_REALTIME, NBT_REALTIME_THREAD_HOOK, IFX_UNSPECIFIED_ERROR);
+    }
+    ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "I/O thread running with SCHED_FIFO priority %d on CPU %d", priority, sched_getcpu());
+    return IFX_SUCCESS;
+}
@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-realtime.h
+ * \brief Real-time setup of the NBT I/O thread.
+ *
+ * \details Intended to be used as nbt_scheduler.thread_hook so that the thread owning the NBT abstraction runs with
+ * \c SCHED_FIFO priority, pinned to a single core and without page faults on its stack or on heap allocations done by
+ * the protocol stack (all memory locked with \c mlockall(), heap trimming disabled and a heap pool prefaulted).
+ *
+ * Requires \c CAP_SYS_NICE and \c CAP_IPC_LOCK (or root) respectively sufficient \c RLIMIT_RTPRIO and
+ * \c RLIMIT_MEMLOCK limits.
+ */
+#ifndef NBT_REALTIME_H
+#define NBT_REALTIME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infineon/ifx-error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Identifier for the real-time setup used in error codes.
+ */
+#define LIB_NBT_REALTIME 0x67U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_realtime_thread_hook().
+ */
+#define NBT_REALTIME_THREAD_HOOK 0x01U
+
+/**
+ * \brief Default \c SCHED_FIFO priority (just below the default priority 50 of threaded interrupt handlers, so that the
+ * I2C controller interrupt is never starved by the I/O thread).
+ */
+#define NBT_REALTIME_DEFAULT_PRIORITY 49
+
+/**
+ * \brief Default number of stack bytes prefaulted on the I/O thread.
+ */
+#define NBT_REALTIME_DEFAULT_STACK_PREFAULT (64U * 1024U)
+
+/**
+ * \brief Default number of heap bytes prefaulted (and kept) for allocations of the protocol stack.
+ */
+#define NBT_REALTIME_DEFAULT_HEAP_PREFAULT (1024U * 1024U)
+
+/**
+ * \brief Value of nbt_realtime_config.cpu for not pinning the thread.
+ */
+#define NBT_REALTIME_NO_CPU (-1)
+
+/** \struct nbt_realtime_config
+ * \brief Real-time settings of a thread (zero sizes / priority select the defaults).
+ */
+struct nbt_realtime_config
+{
+    /**
+     * \brief \c SCHED_FIFO priority.
+     */
+    int priority;
+
+    /**
+     * \brief Core the thread is pinned to (\c NBT_REALTIME_NO_CPU to keep the inherited affinity).
+     */
+    int cpu;
+
+    /**
+     * \brief Number of stack bytes to be prefaulted.
+     */
+    size_t stack_prefault;
+
+    /**
+     * \brief Number of heap bytes to be prefaulted.
+     */
+    size_t heap_prefault;
+};
+
+/**
+ * \brief Locks memory, prefaults stack and heap, pins and switches the calling thread to \c SCHED_FIFO.
+ *
+ * \details Signature matches nbt_scheduler_thread_hook_t so that it can be set as nbt_scheduler.thread_hook. Memory is
+ * unlocked again with \c munlockall() if any step after locking fails.
+ *
+ * \param[in] context Real-time settings (\c const struct nbt_realtime_config *).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_realtime_thread_hook(void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NBT_REALTIME_H
@@ -0,0 +1,478 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-ringlog.c
+ * \brief NFC-readable telemetry ring log stored in an NBT proprietary file.
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "infineon/ifx-apdu.h"
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-logger.h"
+#include "infineon/nbt-cmd.h"
+
+#include "nbt-ringlog.h"
+#include "nbt-utilities.h"
+
+/**
+ * \brief String used as source information for logging.
+ */
+#define LOG_TAG "NBT ring log"
+
+/**
+ * \brief Ring header magic.
+ */
+static const uint8_t NBT_RINGLOG_MAGIC[4] = {'N', 'B', 'T', 'R'};
+
+/**
+ * \brief Calculates CRC-16/CCITT-FALSE checksum.
+ *
+ * \param[in] data Data to be checksummed.
+ * \param[in] length Number of bytes in \c data.
+ * \return uint16_t Checksum.
+ */
+static uint16_t nbt_ringlog_crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFFU;
+    for (size_t i = 0U; i < length; i++)
+    {
+        crc ^= (uint16_t) (data[i] << 8);
+        for (uint8_t bit = 0U; bit < 8U; bit++)
+        {
+            crc = (crc & 0x8000U) ? (uint16_t) ((crc << 1) ^ 0x1021U) : (uint16_t) (crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * \brief Encodes record into its slot representation.
+ *
+ * \param[in] record Record to be encoded.
+ * \param[out] slot Buffer of \c NBT_RINGLOG_RECORD_SIZE bytes.
+ */
+static void nbt_ringlog_encode_record(const struct nbt_ringlog_record *record, uint8_t *slot)
+{
+    memset(slot, 0, NBT_RINGLOG_RECORD_SIZE);
+    slot[0] = (uint8_t) (record->sequence >> 24);
+    slot[1] = (uint8_t) (record->sequence >> 16);
+    slot[2] = (uint8_t) (record->sequence >> 8);
+    slot[3] = (uint8_t) record->sequence;
+    slot[4] = (uint8_t) (record->timestamp >> 24);
+    slot[5] = (uint8_t) (record->timestamp >> 16);
+    slot[6] = (uint8_t) (record->timestamp >> 8);
+    slot[7] = (uint8_t) record->timestamp;
+    slot[8] = record->type;
+    slot[9] = record->length;
+    memcpy(&slot[10], record->payload, record->length);
+    uint16_t crc = nbt_ringlog_crc16(slot, NBT_RINGLOG_RECORD_SIZE - 2U);
+    slot[NBT_RINGLOG_RECORD_SIZE - 2U] = (uint8_t) (crc >> 8);
+    slot[NBT_RINGLOG_RECORD_SIZE - 1U] = (uint8_t) crc;
+}
+
+/**
+ * \brief Decodes single record slot.
+ *
+ * \param[in] slot Buffer of \c NBT_RINGLOG_RECORD_SIZE bytes.
+ * \param[out] record Decoded record.
+ * \return bool \c true if slot holds a valid record.
+ */
+static bool nbt_ringlog_decode_record(const uint8_t *slot, struct nbt_ringlog_record *record)
+{
+    uint16_t crc = (uint16_t) ((slot[NBT_RINGLOG_RECORD_SIZE - 2U] << 8) | slot[NBT_RINGLOG_RECORD_SIZE - 1U]);
+    if (crc != nbt_ringlog_crc16(slot, NBT_RINGLOG_RECORD_SIZE - 2U))
+    {
+        return false;
+    }
+    record->sequence = ((uint32_t) slot[0] << 24) | ((uint32_t) slot[1] << 16) | ((uint32_t) slot[2] << 8) | slot[3];
+    record->timestamp = ((uint32_t) slot[4] << 24) | ((uint32_t) slot[5] << 16) | ((uint32_t) slot[6] << 8) | slot[7];
+    record->type = slot[8];
+    record->length = slot[9];
+    if ((record->sequence == 0U) || (record->length > NBT_RINGLOG_PAYLOAD_SIZE))
+    {
+        return false;
+    }
+    memset(record->payload, 0, sizeof(record->payload));
+    memcpy(record->payload, &slot[10], record->length);
+    return true;
+}
+
+/**
+ * \brief Checks whether ring header is valid for the given number of slots.
+ *
+ * \param[in] header Buffer of \c NBT_RINGLOG_HEADER_SIZE bytes.
+ * \param[out] slots Number of slots stored in header.
+ * \return bool \c true if header is valid.
+ */
+static bool nbt_ringlog_check_header(const uint8_t *header, uint16_t *slots)
+{
+    if ((memcmp(header, NBT_RINGLOG_MAGIC, sizeof(NBT_RINGLOG_MAGIC)) != 0) || (header[4] != NBT_RINGLOG_VERSION) ||
+        (header[5] != NBT_RINGLOG_RECORD_SIZE))
+    {
+        return false;
+    }
+    *slots = (uint16_t) ((header[6] << 8) | header[7]);
+    return (*slots > 0U) && (*slots <= NBT_RINGLOG_MAX_SLOTS);
+}
+
+/**
+ * \brief Writes consecutive record slots with slot-aligned UPDATE BINARY commands.
+ *
+ * \details Selects the file once and never splits a record across two commands (unlike nbt_write_file(), which cuts
+ * at 255 bytes).
+ *
+ * \param[in] self Ring log.
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] first_slot Index of first slot to be written.
+ * \param[in] data Encoded records.
+ * \param[in] count Number of records in \c data.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_ringlog_write_slots(const struct nbt_ringlog *self, nbt_cmd_t *nbt, size_t first_slot, const uint8_t *data, size_t count)
+{
+    ifx_status_t status = nbt_select_file(nbt, self->file_id);
+    ifx_apdu_destroy(nbt->apdu);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not select NBT file 0x%04X", self->file_id);
+        return status;
+    }
+    if (nbt->response->sw != 0x9000U)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid status word for selecting NBT file 0x%04X: 0x%04X", self->file_id, nbt->response->sw);
+        ifx_apdu_response_destroy(nbt->response);
+        return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_FLUSH, IFX_SW_ERROR);
+    }
+    ifx_apdu_response_destroy(nbt->response);
+
+    for (size_t written = 0U; written < count; written += NBT_RINGLOG_RECORDS_PER_COMMAND)
+    {
+        size_t chunk = ((count - written) < NBT_RINGLOG_RECORDS_PER_COMMAND) ? (count - written) : NBT_RINGLOG_RECORDS_PER_COMMAND;
+        uint16_t offset = (uint16_t) (NBT_RINGLOG_HEADER_SIZE + ((first_slot + written) * NBT_RINGLOG_RECORD_SIZE));
+        status = nbt_update_binary(nbt, offset, (uint16_t) (chunk * NBT_RINGLOG_RECORD_SIZE), (uint8_t *) &data[written * NBT_RINGLOG_RECORD_SIZE]);
+        ifx_apdu_destroy(nbt->apdu);
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not write NBT file 0x%04X", self->file_id);
+            return status;
+        }
+        if (nbt->response->sw != 0x9000U)
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid status word for writing NBT file 0x%04X: 0x%04X", self->file_id, nbt->response->sw);
+            ifx_apdu_response_destroy(nbt->response);
+            return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_FLUSH, IFX_SW_ERROR);
+        }
+        ifx_apdu_response_destroy(nbt->response);
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Initializes ring log writer state.
+ *
+ * \param[in] self Ring log to be initialized.
+ * \param[in] file_id Proprietary file holding the ring.
+ * \param[in] slots Number of record slots (at most \c NBT_RINGLOG_MAX_SLOTS).
+ * \param[in] batch Number of staged records that triggers a flush (0 for \c NBT_RINGLOG_DEFAULT_BATCH).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_initialize(struct nbt_ringlog *self, enum nbt_fileid file_id, uint16_t slots, size_t batch)
+{
+    if ((self == NULL) || (slots < 2U) || (slots > NBT_RINGLOG_MAX_SLOTS) || (batch > slots))
+    {
+        return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_INITIALIZE, IFX_ILLEGAL_ARGUMENT);
+    }
+    if (pthread_mutex_init(&self->lock, NULL) != 0)
+    {
+        return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_INITIALIZE, IFX_UNSPECIFIED_ERROR);
+    }
+    self->file_id = file_id;
+    self->slots = slots;
+    self->batch = (batch == 0U) ? ((NBT_RINGLOG_DEFAULT_BATCH < slots) ? NBT_RINGLOG_DEFAULT_BATCH : slots) : batch;
+    self->pending_start = 0U;
+    self->pending_count = 0U;
+    self->next_sequence = 1U;
+    self->dropped = 0U;
+    self->opened = false;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Recovers the write position from the tag, formats the region if it does not contain a valid ring.
+ *
+ * \details Must be called from the NBT I/O thread (e.g. as scheduler job) with the NBT application selected.
+ *
+ * \param[in] self Ring log.
+ * \param[in] nbt NBT command abstraction.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_open(struct nbt_ringlog *self, nbt_cmd_t *nbt)
+{
+    if ((self == NULL) || (nbt == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_OPEN, IFX_ILLEGAL_ARGUMENT);
+    }
+
+    // Read whole ring region at once
+    uint8_t region[NBT_PROPRIETARY_FILE_SIZE];
+    size_t region_len = NBT_RINGLOG_HEADER_SIZE + ((size_t) self->slots * NBT_RINGLOG_RECORD_SIZE);
+    ifx_status_t status = nbt_read_file(nbt, self->file_id, 0U, region_len, region);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not read ring region from NBT file 0x%04X", self->file_id);
+        return status;
+    }
+
+    uint32_t newest = 0U;
+    uint16_t stored_slots = 0U;
+    if (nbt_ringlog_check_header(region, &stored_slots) && (stored_slots == self->slots))
+    {
+        for (uint16_t i = 0U; i < self->slots; i++)
+        {
+            struct nbt_ringlog_record record;
+            if (nbt_ringlog_decode_record(&region[NBT_RINGLOG_HEADER_SIZE + (i * NBT_RINGLOG_RECORD_SIZE)], &record) &&
+                (record.sequence > newest))
+            {
+                newest = record.sequence;
+            }
+        }
+    }
+    else
+    {
+        // Format region: header followed by empty slots, written in one go
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_INFO, "Formatting ring region in NBT file 0x%04X", self->file_id);
+        memset(region, 0, region_len);
+        memcpy(region, NBT_RINGLOG_MAGIC, sizeof(NBT_RINGLOG_MAGIC));
+        region[4] = NBT_RINGLOG_VERSION;
+        region[5] = NBT_RINGLOG_RECORD_SIZE;
+        region[6] = (uint8_t) (self->slots >> 8);
+        region[7] = (uint8_t) self->slots;
+        status = nbt_write_file(nbt, self->file_id, 0U, region, region_len);
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not format ring region in NBT file 0x%04X", self->file_id);
+            return status;
+        }
+    }
+
+    // Renumber records staged before the ring state was known
+    pthread_mutex_lock(&self->lock);
+    self->next_sequence = newest + 1U;
+    for (size_t i = 0U; i < self->pending_count; i++)
+    {
+        self->pending[(self->pending_start + i) % NBT_RINGLOG_MAX_SLOTS].sequence = self->next_sequence++;
+    }
+    self->opened = true;
+    pthread_mutex_unlock(&self->lock);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Stages record for the next flush (thread-safe, no NBT communication).
+ *
+ * \param[in] self Ring log.
+ * \param[in] type Record type.
+ * \param[in] payload Record payload (may be \c NULL if \c length is 0).
+ * \param[in] length Payload length (at most \c NBT_RINGLOG_PAYLOAD_SIZE).
+ * \param[out] flush_due Optional, set to \c true if enough records are staged to warrant a flush.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_append(struct nbt_ringlog *self, enum nbt_ringlog_type type, const uint8_t *payload, size_t length,
+                                bool *flush_due)
+{
+    if ((self == NULL) || (length > NBT_RINGLOG_PAYLOAD_SIZE) || ((payload == NULL) && (length > 0U)))
+    {
+        return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_APPEND, IFX_ILLEGAL_ARGUMENT);
+    }
+
+    pthread_mutex_lock(&self->lock);
+    if (self->pending_count == self->slots)
+    {
+        // Oldest staged record would be overwritten by this batch anyway
+        self->pending_start = (self->pending_start + 1U) % NBT_RINGLOG_MAX_SLOTS;
+        self->pending_count--;
+        self->dropped++;
+    }
+    struct nbt_ringlog_record *record = &self->pending[(self->pending_start + self->pending_count) % NBT_RINGLOG_MAX_SLOTS];
+    record->sequence = self->next_sequence++;
+    record->timestamp = (uint32_t) time(NULL);
+    record->type = (uint8_t) type;
+    record->length = (uint8_t) length;
+    memset(record->payload, 0, sizeof(record->payload));
+    if (length > 0U)
+    {
+        memcpy(record->payload, payload, length);
+    }
+    self->pending_count++;
+    if (flush_due != NULL)
+    {
+        *flush_due = self->pending_count >= self->batch;
+    }
+    pthread_mutex_unlock(&self->lock);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Writes all staged records to the tag.
+ *
+ * \details Staged records occupy consecutive slots and are written with slot-aligned UPDATE BINARY commands of up to
+ * \c NBT_RINGLOG_RECORDS_PER_COMMAND records each, split additionally only if the batch wraps around the end of the
+ * ring. Must be called from the NBT I/O thread.
+ *
+ * \param[in] self Ring log.
+ * \param[in] nbt NBT command abstraction.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_flush(struct nbt_ringlog *self, nbt_cmd_t *nbt)
+{
+    if ((self == NULL) || (nbt == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_FLUSH, IFX_ILLEGAL_ARGUMENT);
+    }
+    if (!self->opened)
+    {
+        ifx_status_t status = nbt_ringlog_open(self, nbt);
+        if (ifx_error_check(status))
+        {
+            return status;
+        }
+    }
+
+    // Snapshot staged records, appends may continue while writing
+    uint8_t batch[NBT_RINGLOG_MAX_SLOTS * NBT_RINGLOG_RECORD_SIZE];
+    pthread_mutex_lock(&self->lock);
+    size_t count = self->pending_count;
+    if (count == 0U)
+    {
+        pthread_mutex_unlock(&self->lock);
+        return IFX_SUCCESS;
+    }
+    uint32_t first_sequence = self->pending[self->pending_start].sequence;
+    for (size_t i = 0U; i < count; i++)
+    {
+        nbt_ringlog_encode_record(&self->pending[(self->pending_start + i) % NBT_RINGLOG_MAX_SLOTS], &batch[i * NBT_RINGLOG_RECORD_SIZE]);
+    }
+    pthread_mutex_unlock(&self->lock);
+
+    // Consecutive sequence numbers map to consecutive slots, split only at the end of the ring
+    size_t first_slot = first_sequence % self->slots;
+    size_t head_count = ((self->slots - first_slot) < count) ? (self->slots - first_slot) : count;
+    ifx_status_t status = nbt_ringlog_write_slots(self, nbt, first_slot, batch, head_count);
+    if (!ifx_error_check(status) && (head_count < count))
+    {
+        status = nbt_ringlog_write_slots(self, nbt, 0U, &batch[head_count * NBT_RINGLOG_RECORD_SIZE], count - head_count);
+    }
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not write %zu ring records to NBT file 0x%04X", count, self->file_id);
+        return status;
+    }
+
+    // Release written records (some might have been dropped by concurrent appends meanwhile)
+    pthread_mutex_lock(&self->lock);
+    uint32_t last_sequence = first_sequence + (uint32_t) count;
+    while ((self->pending_count > 0U) && (self->pending[self->pending_start].sequence < last_sequence))
+    {
+        self->pending_start = (self->pending_start + 1U) % NBT_RINGLOG_MAX_SLOTS;
+        self->pending_count--;
+    }
+    pthread_mutex_unlock(&self->lock);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Scheduler job adapter for nbt_ringlog_flush().
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] context struct nbt_ringlog to be flushed.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ * \see nbt_scheduler_submit()
+ */
+ifx_status_t nbt_ringlog_flush_job(nbt_cmd_t *nbt, void *context)
+{
+    return nbt_ringlog_flush((struct nbt_ringlog *) context, nbt);
+}
+
+/**
+ * \brief Decodes ring region into records ordered newest first.
+ *
+ * \details Slots with invalid checksum or sequence number 0 are skipped.
+ *
+ * \param[in] region Ring region as read with a single nbt_read_file().
+ * \param[in] region_len Number of bytes in \c region.
+ * \param[out] records Buffer for decoded records.
+ * \param[in] records_len Capacity of \c records.
+ * \param[out] records_count Number of decoded records.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_decode(const uint8_t *region, size_t region_len, struct nbt_ringlog_record *records, size_t records_len,
+                                size_t *records_count)
+{
+    if ((region == NULL) || (records == NULL) || (records_count == NULL) || (region_len < NBT_RINGLOG_HEADER_SIZE))
+    {
+        return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_DECODE, IFX_ILLEGAL_ARGUMENT);
+    }
+    uint16_t slots = 0U;
+    if (!nbt_ringlog_check_header(region, &slots))
+    {
+        return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_DECODE, IFX_PROGRAMMING_ERROR);
+    }
+    if (region_len < (NBT_RINGLOG_HEADER_SIZE + ((size_t) slots * NBT_RINGLOG_RECORD_SIZE)))
+    {
+        return IFX_ERROR(LIB_NBT_RINGLOG, NBT_RINGLOG_DECODE, IFX_TOO_LITTLE_DATA);
+    }
+
+    // Insertion sort by descending sequence number keeps at most records_len newest records
+    size_t count = 0U;
+    for (uint16_t i = 0U; i < slots; i++)
+    {
+        struct nbt_ringlog_record record;
+        if (!nbt_ringlog_decode_record(&region[NBT_RINGLOG_HEADER_SIZE + (i * NBT_RINGLOG_RECORD_SIZE)], &record))
+        {
+            continue;
+        }
+        size_t position = count;
+        while ((position > 0U) && (records[position - 1U].sequence < record.sequence))
+        {
+            position--;
+        }
+        if (position >= records_len)
+        {
+            continue;
+        }
+        size_t last = (count < records_len) ? count : (records_len - 1U);
+        memmove(&records[position + 1U], &records[position], (last - position) * sizeof(struct nbt_ringlog_record));
+        records[position] = record;
+        if (count < records_len)
+        {
+            count++;
+        }
+    }
+    *records_count = count;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Frees ring log resources (staged records are discarded).
+ *
+ * \param[in] self Ring log.
+ */
+void nbt_ringlog_destroy(struct nbt_ringlog *self)
+{
+    if (self == NULL)
+    {
+        return;
+    }
+    if (self->pending_count > 0U)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Discarding %zu unflushed ring records", self->pending_count);
+    }
+    pthread_mutex_destroy(&self->lock);
+    self->pending_count = 0U;
+}
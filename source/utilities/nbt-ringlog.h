@@ -0,0 +1,308 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-ringlog.h
+ * \brief NFC-readable telemetry ring log stored in an NBT proprietary file.
+ *
+ * \details Layout of the ring region (all integers big endian):
+ *
+ *   | Offset          | Size | Content                                                              |
+ *   | --------------- | ---- | -------------------------------------------------------------------- |
+ *   | 0               | 4    | Magic \c "NBTR"                                                      |
+ *   | 4               | 1    | Format version (\c NBT_RINGLOG_VERSION)                              |
+ *   | 5               | 1    | Record size in bytes (\c NBT_RINGLOG_RECORD_SIZE)                    |
+ *   | 6               | 2    | Number of record slots                                               |
+ *   | 8               | 24   | Reserved (0x00)                                                      |
+ *   | 32 + n * 32     | 32   | Record slot \c n                                                     |
+ *
+ * Record slot:
+ *
+ *   | Offset | Size | Content                                                                   |
+ *   | ------ | ---- | ------------------------------------------------------------------------- |
+ *   | 0      | 4    | Sequence number (starts at 1, slot = sequence % number of slots)          |
+ *   | 4      | 4    | Timestamp (seconds since epoch)                                           |
+ *   | 8      | 1    | Record type (\c enum nbt_ringlog_type)                                    |
+ *   | 9      | 1    | Payload length                                                            |
+ *   | 10     | 20   | Payload (zero padded)                                                     |
+ *   | 30     | 2    | CRC-16/CCITT-FALSE over bytes 0..29                                       |
+ *
+ * The header is only written when the region is formatted. The write position is recovered from the highest valid
+ * sequence number, so appends never touch the header and readers get newest-first order from a single read of the
+ * region (see nbt_ringlog_decode()).
+ */
+#ifndef NBT_RINGLOG_H
+#define NBT_RINGLOG_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/nbt-cmd.h"
+
+#include "nbt-utilities.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Identifier for the NBT ring log used in error codes.
+ */
+#define LIB_NBT_RINGLOG 0x61U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_ringlog_initialize().
+ */
+#define NBT_RINGLOG_INITIALIZE 0x01U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_ringlog_open().
+ */
+#define NBT_RINGLOG_OPEN 0x02U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_ringlog_append().
+ */
+#define NBT_RINGLOG_APPEND 0x03U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_ringlog_flush().
+ */
+#define NBT_RINGLOG_FLUSH 0x04U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_ringlog_decode().
+ */
+#define NBT_RINGLOG_DECODE 0x05U
+
+/**
+ * \brief Ring log format version.
+ */
+#define NBT_RINGLOG_VERSION 0x01U
+
+/**
+ * \brief Size of ring header in bytes (one record slot to keep slots aligned).
+ */
+#define NBT_RINGLOG_HEADER_SIZE 32U
+
+/**
+ * \brief Size of a single record slot in bytes.
+ */
+#define NBT_RINGLOG_RECORD_SIZE 32U
+
+/**
+ * \brief Maximum payload length of a single record.
+ */
+#define NBT_RINGLOG_PAYLOAD_SIZE 20U
+
+/**
+ * \brief Maximum number of records written with a single UPDATE BINARY command (fits into 255 bytes).
+ */
+#define NBT_RINGLOG_RECORDS_PER_COMMAND (0xFFU / NBT_RINGLOG_RECORD_SIZE)
+
+/**
+ * \brief Maximum number of record slots (ring spanning a full proprietary file).
+ */
+#define NBT_RINGLOG_MAX_SLOTS ((NBT_PROPRIETARY_FILE_SIZE - NBT_RINGLOG_HEADER_SIZE) / NBT_RINGLOG_RECORD_SIZE)
+
+/**
+ * \brief Default number of staged records that triggers a flush.
+ */
+#define NBT_RINGLOG_DEFAULT_BATCH 8U
+
+/** \enum nbt_ringlog_type
+ * \brief Record types.
+ */
+enum nbt_ringlog_type
+{
+    /**
+     * \brief Device status snapshot (see nbt-health.h for the payload).
+     */
+    NBT_RINGLOG_TYPE_STATUS = 0x01U,
+
+    /**
+     * \brief Generic event.
+     */
+    NBT_RINGLOG_TYPE_EVENT = 0x02U,
+
+    /**
+     * \brief Error report.
+     */
+    NBT_RINGLOG_TYPE_ERROR = 0x03U
+};
+
+/** \struct nbt_ringlog_record
+ * \brief Decoded ring log record.
+ */
+struct nbt_ringlog_record
+{
+    /**
+     * \brief Monotonic sequence number (never 0 for valid records).
+     */
+    uint32_t sequence;
+
+    /**
+     * \brief Timestamp in seconds since epoch.
+     */
+    uint32_t timestamp;
+
+    /**
+     * \brief Record type (see \c enum nbt_ringlog_type).
+     */
+    uint8_t type;
+
+    /**
+     * \brief Number of valid bytes in nbt_ringlog_record.payload.
+     */
+    uint8_t length;
+
+    /**
+     * \brief Record payload.
+     */
+    uint8_t payload[NBT_RINGLOG_PAYLOAD_SIZE];
+};
+
+/** \struct nbt_ringlog
+ * \brief Ring log writer state.
+ */
+struct nbt_ringlog
+{
+    /**
+     * \brief NBT file holding the ring.
+     */
+    enum nbt_fileid file_id;
+
+    /**
+     * \brief Number of record slots in the ring.
+     */
+    uint16_t slots;
+
+    /**
+     * \brief Number of staged records after which nbt_ringlog_append() requests a flush.
+     */
+    size_t batch;
+
+    /**
+     * \brief Lock protecting staged records and sequence counter.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * \brief Records staged for the next flush (FIFO, oldest at nbt_ringlog.pending_start).
+     */
+    struct nbt_ringlog_record pending[NBT_RINGLOG_MAX_SLOTS];
+
+    /**
+     * \brief Index of oldest staged record.
+     */
+    size_t pending_start;
+
+    /**
+     * \brief Number of staged records.
+     */
+    size_t pending_count;
+
+    /**
+     * \brief Sequence number for the next appended record.
+     */
+    uint32_t next_sequence;
+
+    /**
+     * \brief Number of staged records dropped because the ring wrapped before they were flushed.
+     */
+    uint64_t dropped;
+
+    /**
+     * \brief \c true once nbt_ringlog_open() recovered the ring state from the tag.
+     */
+    bool opened;
+};
+
+/**
+ * \brief Initializes ring log writer state.
+ *
+ * \param[in] self Ring log to be initialized.
+ * \param[in] file_id Proprietary file holding the ring.
+ * \param[in] slots Number of record slots (at most \c NBT_RINGLOG_MAX_SLOTS).
+ * \param[in] batch Number of staged records that triggers a flush (0 for \c NBT_RINGLOG_DEFAULT_BATCH).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_initialize(struct nbt_ringlog *self, enum nbt_fileid file_id, uint16_t slots, size_t batch);
+
+/**
+ * \brief Recovers the write position from the tag, formats the region if it does not contain a valid ring.
+ *
+ * \details Must be called from the NBT I/O thread (e.g. as scheduler job) with the NBT application selected.
+ *
+ * \param[in] self Ring log.
+ * \param[in] nbt NBT command abstraction.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_open(struct nbt_ringlog *self, nbt_cmd_t *nbt);
+
+/**
+ * \brief Stages record for the next flush (thread-safe, no NBT communication).
+ *
+ * \param[in] self Ring log.
+ * \param[in] type Record type.
+ * \param[in] payload Record payload (may be \c NULL if \c length is 0).
+ * \param[in] length Payload length (at most \c NBT_RINGLOG_PAYLOAD_SIZE).
+ * \param[out] flush_due Optional, set to \c true if enough records are staged to warrant a flush.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_append(struct nbt_ringlog *self, enum nbt_ringlog_type type, const uint8_t *payload, size_t length,
+                                bool *flush_due);
+
+/**
+ * \brief Writes all staged records to the tag.
+ *
+ * \details Staged records occupy consecutive slots and are written with slot-aligned UPDATE BINARY commands of up to
+ * \c NBT_RINGLOG_RECORDS_PER_COMMAND records each, split additionally only if the batch wraps around the end of the
+ * ring. Must be called from the NBT I/O thread.
+ *
+ * \param[in] self Ring log.
+ * \param[in] nbt NBT command abstraction.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_flush(struct nbt_ringlog *self, nbt_cmd_t *nbt);
+
+/**
+ * \brief Scheduler job adapter for nbt_ringlog_flush().
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] context struct nbt_ringlog to be flushed.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ * \see nbt_scheduler_submit()
+ */
+ifx_status_t nbt_ringlog_flush_job(nbt_cmd_t *nbt, void *context);
+
+/**
+ * \brief Decodes ring region into records ordered newest first.
+ *
+ * \details Slots with invalid checksum or sequence number 0 are skipped.
+ *
+ * \param[in] region Ring region as read with a single nbt_read_file().
+ * \param[in] region_len Number of bytes in \c region.
+ * \param[out] records Buffer for decoded records.
+ * \param[in] records_len Capacity of \c records.
+ * \param[out] records_count Number of decoded records.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_ringlog_decode(const uint8_t *region, size_t region_len, struct nbt_ringlog_record *records, size_t records_len,
+                                size_t *records_count);
+
+/**
+ * \brief Frees ring log resources (staged records are discarded).
+ *
+ * \param[in] self Ring log.
+ */
+void nbt_ringlog_destroy(struct nbt_ringlog *self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NBT_RINGLOG_H
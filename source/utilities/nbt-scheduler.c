@@ -0,0 +1,403 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-scheduler.c
+ * \brief Priority-aware single-owner command scheduler for shared NBT access.
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-logger.h"
+#include "infineon/nbt-cmd.h"
+
+#include "nbt-scheduler.h"
+#include "nbt-utilities.h"
+
+/**
+ * \brief String used as source information for logging.
+ */
+#define LOG_TAG "NBT scheduler"
+
+/** \struct nbt_scheduler_waiter
+ * \brief Synchronization state for nbt_scheduler_execute().
+ */
+struct nbt_scheduler_waiter
+{
+    /**
+     * \brief Job to be executed.
+     */
+    nbt_scheduler_job_t job;
+
+    /**
+     * \brief Context for nbt_scheduler_waiter.job.
+     */
+    void *context;
+
+    /**
+     * \brief Status returned by nbt_scheduler_waiter.job.
+     */
+    ifx_status_t status;
+
+    /**
+     * \brief \c true once nbt_scheduler_waiter.status is valid.
+     */
+    bool done;
+
+    /**
+     * \brief Lock protecting nbt_scheduler_waiter.done.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * \brief Signalled once the job has completed.
+     */
+    pthread_cond_t completed;
+};
+
+/**
+ * \brief Takes the next job from the highest non-empty priority queue.
+ *
+ * \details Must be called with nbt_scheduler.lock held.
+ *
+ * \param[in] self Scheduler.
+ * \param[out] priority Priority of the returned job.
+ * \return struct nbt_scheduler_job * Next job or \c NULL if all queues are empty.
+ */
+static struct nbt_scheduler_job *nbt_scheduler_dequeue(struct nbt_scheduler *self, size_t *priority)
+{
+    for (size_t i = 0U; i < NBT_PRIORITY_COUNT; i++)
+    {
+        struct nbt_scheduler_job *job = self->heads[i];
+        if (job != NULL)
+        {
+            self->heads[i] = job->next;
+            if (self->heads[i] == NULL)
+            {
+                self->tails[i] = NULL;
+            }
+            *priority = i;
+            return job;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief I/O thread serving queued jobs until the scheduler is stopped and all queues are drained.
+ *
+ * \param[in] arg Scheduler.
+ * \return void * Always \c NULL.
+ */
+static void *nbt_scheduler_thread(void *arg)
+{
+    struct nbt_scheduler *self = (struct nbt_scheduler *) arg;
+
+    ifx_status_t status = IFX_SUCCESS;
+    if (self->thread_hook != NULL)
+    {
+        status = self->thread_hook(self->thread_hook_context);
+    }
+    pthread_mutex_lock(&self->lock);
+    self->start_status = status;
+    self->started = true;
+    self->running = !ifx_error_check(status);
+    pthread_cond_broadcast(&self->available);
+    pthread_mutex_unlock(&self->lock);
+    if (ifx_error_check(status))
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&self->lock);
+    while (true)
+    {
+        size_t priority = 0U;
+        struct nbt_scheduler_job *job = nbt_scheduler_dequeue(self, &priority);
+        if (job == NULL)
+        {
+            if (!self->running)
+            {
+                break;
+            }
+            pthread_cond_wait(&self->available, &self->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&self->lock);
+
+        // Only this thread ever touches the NBT abstraction
+        if (self->job_hook != NULL)
+        {
+            self->job_hook(self->job_hook_context, (enum nbt_scheduler_priority) priority);
+        }
+        status = job->job(self->nbt, job->context);
+        if (job->completion != NULL)
+        {
+            job->completion(status, job->context);
+        }
+        free(job);
+
+        pthread_mutex_lock(&self->lock);
+        self->executed[priority]++;
+    }
+    pthread_mutex_unlock(&self->lock);
+    return NULL;
+}
+
+/**
+ * \brief Initializes scheduler and starts the I/O thread.
+ *
+ * \details nbt_scheduler.thread_hook, nbt_scheduler.job_hook and their contexts may be set before calling this
+ * function, all other members are initialized here.
+ *
+ * \param[in] self Scheduler to be started.
+ * \param[in] nbt NBT command abstraction to be owned by the I/O thread. Must not be used by any other thread afterwards.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_scheduler_start(struct nbt_scheduler *self, nbt_cmd_t *nbt)
+{
+    if ((self == NULL) || (nbt == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_START, IFX_ILLEGAL_ARGUMENT);
+    }
+    self->nbt = nbt;
+    memset(self->heads, 0, sizeof(self->heads));
+    memset(self->tails, 0, sizeof(self->tails));
+    memset(self->executed, 0, sizeof(self->executed));
+    self->start_status = IFX_SUCCESS;
+    self->started = false;
+    self->running = false;
+    if (pthread_mutex_init(&self->lock, NULL) != 0)
+    {
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_START, IFX_UNSPECIFIED_ERROR);
+    }
+    if (pthread_cond_init(&self->available, NULL) != 0)
+    {
+        pthread_mutex_destroy(&self->lock);
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_START, IFX_UNSPECIFIED_ERROR);
+    }
+    if (pthread_create(&self->thread, NULL, nbt_scheduler_thread, self) != 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not create NBT I/O thread");
+        pthread_cond_destroy(&self->available);
+        pthread_mutex_destroy(&self->lock);
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_START, IFX_UNSPECIFIED_ERROR);
+    }
+
+    // Wait for thread hook to report back
+    pthread_mutex_lock(&self->lock);
+    while (!self->started)
+    {
+        pthread_cond_wait(&self->available, &self->lock);
+    }
+    ifx_status_t status = self->start_status;
+    pthread_mutex_unlock(&self->lock);
+    if (ifx_error_check(status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not prepare NBT I/O thread");
+        pthread_join(self->thread, NULL);
+        pthread_cond_destroy(&self->available);
+        pthread_mutex_destroy(&self->lock);
+        return status;
+    }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Queues job for asynchronous execution on the I/O thread.
+ *
+ * \details Jobs of the same priority are executed in submission order, higher priorities always jump ahead of queued
+ * lower priority jobs. A job currently executing is never interrupted.
+ *
+ * \param[in] self Scheduler.
+ * \param[in] priority Job priority.
+ * \param[in] job Job to be executed.
+ * \param[in] completion Optional completion callback (may be \c NULL).
+ * \param[in] context Context passed to job and completion callback.
+ * \return ifx_status_t \c IFX_SUCCESS if job has been queued, any other value in case of error.
+ */
+ifx_status_t nbt_scheduler_submit(struct nbt_scheduler *self, enum nbt_scheduler_priority priority, nbt_scheduler_job_t job,
+                                  nbt_scheduler_completion_t completion, void *context)
+{
+    if ((self == NULL) || (job == NULL) || (priority >= NBT_PRIORITY_COUNT))
+    {
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_SUBMIT, IFX_ILLEGAL_ARGUMENT);
+    }
+    struct nbt_scheduler_job *entry = (struct nbt_scheduler_job *) malloc(sizeof(struct nbt_scheduler_job));
+    if (entry == NULL)
+    {
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_SUBMIT, IFX_OUT_OF_MEMORY);
+    }
+    entry->job = job;
+    entry->completion = completion;
+    entry->context = context;
+    entry->next = NULL;
+
+    pthread_mutex_lock(&self->lock);
+    if (!self->running)
+    {
+        pthread_mutex_unlock(&self->lock);
+        free(entry);
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_SUBMIT, NBT_SCHEDULER_STOPPED);
+    }
+    if (self->tails[priority] == NULL)
+    {
+        self->heads[priority] = entry;
+    }
+    else
+    {
+        self->tails[priority]->next = entry;
+    }
+    self->tails[priority] = entry;
+    pthread_cond_signal(&self->available);
+    pthread_mutex_unlock(&self->lock);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Job wrapper for nbt_scheduler_execute().
+ *
+ * \param[in] nbt NBT command abstraction owned by the scheduler.
+ * \param[in] context struct nbt_scheduler_waiter.
+ * \return ifx_status_t Status of wrapped job.
+ */
+static ifx_status_t nbt_scheduler_waiter_job(nbt_cmd_t *nbt, void *context)
+{
+    struct nbt_scheduler_waiter *waiter = (struct nbt_scheduler_waiter *) context;
+    return waiter->job(nbt, waiter->context);
+}
+
+/**
+ * \brief Completion callback for nbt_scheduler_execute() waking up the waiting thread.
+ *
+ * \param[in] status Status returned by the job.
+ * \param[in] context struct nbt_scheduler_waiter.
+ */
+static void nbt_scheduler_waiter_completion(ifx_status_t status, void *context)
+{
+    struct nbt_scheduler_waiter *waiter = (struct nbt_scheduler_waiter *) context;
+    pthread_mutex_lock(&waiter->lock);
+    waiter->status = status;
+    waiter->done = true;
+    pthread_cond_signal(&waiter->completed);
+    pthread_mutex_unlock(&waiter->lock);
+}
+
+/**
+ * \brief Queues job and blocks until it has been executed.
+ *
+ * \details Must not be called from the I/O thread itself.
+ *
+ * \param[in] self Scheduler.
+ * \param[in] priority Job priority.
+ * \param[in] job Job to be executed.
+ * \param[in] context Context passed to job.
+ * \return ifx_status_t Status returned by the job, any other value in case of error.
+ */
+ifx_status_t nbt_scheduler_execute(struct nbt_scheduler *self, enum nbt_scheduler_priority priority, nbt_scheduler_job_t job, void *context)
+{
+    if ((self == NULL) || (job == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_EXECUTE, IFX_ILLEGAL_ARGUMENT);
+    }
+    if (pthread_equal(pthread_self(), self->thread))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Blocking execution requested from NBT I/O thread");
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_EXECUTE, IFX_PROGRAMMING_ERROR);
+    }
+
+    struct nbt_scheduler_waiter waiter = {.job = job, .context = context, .status = IFX_SUCCESS, .done = false};
+    if (pthread_mutex_init(&waiter.lock, NULL) != 0)
+    {
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_EXECUTE, IFX_UNSPECIFIED_ERROR);
+    }
+    if (pthread_cond_init(&waiter.completed, NULL) != 0)
+    {
+        pthread_mutex_destroy(&waiter.lock);
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_EXECUTE, IFX_UNSPECIFIED_ERROR);
+    }
+    ifx_status_t status = nbt_scheduler_submit(self, priority, nbt_scheduler_waiter_job, nbt_scheduler_waiter_completion, &waiter);
+    if (!ifx_error_check(status))
+    {
+        pthread_mutex_lock(&waiter.lock);
+        while (!waiter.done)
+        {
+            pthread_cond_wait(&waiter.completed, &waiter.lock);
+        }
+        status = waiter.status;
+        pthread_mutex_unlock(&waiter.lock);
+    }
+    pthread_cond_destroy(&waiter.completed);
+    pthread_mutex_destroy(&waiter.lock);
+    return status;
+}
+
+/**
+ * \brief Stops I/O thread and frees scheduler resources.
+ *
+ * \details Jobs already queued are still executed before the I/O thread terminates.
+ *
+ * \param[in] self Scheduler to be stopped.
+ */
+void nbt_scheduler_stop(struct nbt_scheduler *self)
+{
+    if (self == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&self->lock);
+    self->running = false;
+    pthread_cond_broadcast(&self->available);
+    pthread_mutex_unlock(&self->lock);
+    pthread_join(self->thread, NULL);
+    pthread_cond_destroy(&self->available);
+    pthread_mutex_destroy(&self->lock);
+    ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_DEBUG, "Executed jobs (pass-through/status/bulk/probe): %llu/%llu/%llu/%llu",
+                   (unsigned long long) self->executed[NBT_PRIORITY_PASS_THROUGH], (unsigned long long) self->executed[NBT_PRIORITY_STATUS],
+                   (unsigned long long) self->executed[NBT_PRIORITY_BULK], (unsigned long long) self->executed[NBT_PRIORITY_PROBE]);
+}
+
+/**
+ * \brief Scheduler job fetching a pending pass-through command from the NBT and sending the handler's response.
+ *
+ * \details Meant to be submitted with \c NBT_PRIORITY_PASS_THROUGH as soon as the NBT signals a pass-through command,
+ * so that it jumps ahead of queued bulk writes. If the handler fails, status word \c 6F00 is sent so that the NFC
+ * reader is not left waiting.
+ *
+ * \param[in] nbt NBT command abstraction owned by the scheduler.
+ * \param[in] context Pass-through handler (\c const struct nbt_pass_through *).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_scheduler_pass_through_job(nbt_cmd_t *nbt, void *context)
+{
+    const struct nbt_pass_through *pass_through = (const struct nbt_pass_through *) context;
+    if ((nbt == NULL) || (pass_through == NULL) || (pass_through->handler == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_SCHEDULER, NBT_SCHEDULER_PASS_THROUGH, IFX_ILLEGAL_ARGUMENT);
+    }
+    ifx_apdu_t command = {0};
+    ifx_status_t status = nbt_get_passthrough_apdu(nbt, &command);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    ifx_apdu_response_t response = {0};
+    ifx_status_t handler_status = pass_through->handler(&command, &response, pass_through->context);
+    ifx_apdu_destroy(&command);
+    if (ifx_error_check(handler_status))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_WARN, "Pass-through handler failed, answering with 6F00");
+        ifx_apdu_response_destroy(&response);
+        response.data = NULL;
+        response.len = 0U;
+        response.sw = 0x6F00U;
+    }
+    status = nbt_set_passthrough_response(nbt, &response);
+    ifx_apdu_response_destroy(&response);
+    return ifx_error_check(handler_status) ? handler_status : status;
+}
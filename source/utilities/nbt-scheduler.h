@@ -0,0 +1,316 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-scheduler.h
+ * \brief Priority-aware single-owner command scheduler for shared NBT access.
+ *
+ * \details A single I/O thread owns the \c nbt_cmd_t abstraction. Producers (NDEF updates, status writes, health probes,
+ * pass-through responses) submit jobs with a priority and get notified asynchronously when the job has completed.
+ */
+#ifndef NBT_SCHEDULER_H
+#define NBT_SCHEDULER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infineon/ifx-apdu.h"
+#include "infineon/ifx-error.h"
+#include "infineon/nbt-cmd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Identifier for the NBT scheduler used in error codes.
+ */
+#define LIB_NBT_SCHEDULER 0x60U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_scheduler_start().
+ */
+#define NBT_SCHEDULER_START 0x01U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_scheduler_submit().
+ */
+#define NBT_SCHEDULER_SUBMIT 0x02U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_scheduler_execute().
+ */
+#define NBT_SCHEDULER_EXECUTE 0x03U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_scheduler_pass_through_job().
+ */
+#define NBT_SCHEDULER_PASS_THROUGH 0x04U
+
+/**
+ * \brief Error reason if a job is submitted to a scheduler that is not running.
+ */
+#define NBT_SCHEDULER_STOPPED 0x20U
+
+/** \enum nbt_scheduler_priority
+ * \brief Job priorities, lower values are served first.
+ */
+enum nbt_scheduler_priority
+{
+    /**
+     * \brief Pass-through responses (an NFC reader is waiting on the other end).
+     */
+    NBT_PRIORITY_PASS_THROUGH = 0U,
+
+    /**
+     * \brief Status writes to proprietary files.
+     */
+    NBT_PRIORITY_STATUS = 1U,
+
+    /**
+     * \brief Bulk writes like NDEF updates.
+     */
+    NBT_PRIORITY_BULK = 2U,
+
+    /**
+     * \brief Health probes, only served while no other job is pending so they never delay real work.
+     */
+    NBT_PRIORITY_PROBE = 3U,
+
+    /**
+     * \brief Number of priority levels.
+     */
+    NBT_PRIORITY_COUNT = 4U
+};
+
+/**
+ * \brief Job executed on the scheduler's I/O thread with exclusive access to the NBT abstraction.
+ *
+ * \param[in] nbt NBT command abstraction owned by the scheduler.
+ * \param[in] context Arbitrary context passed to nbt_scheduler_submit().
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+typedef ifx_status_t (*nbt_scheduler_job_t)(nbt_cmd_t *nbt, void *context);
+
+/**
+ * \brief Completion callback invoked on the scheduler's I/O thread after a job has finished.
+ *
+ * \param[in] status Status returned by the job.
+ * \param[in] context Arbitrary context passed to nbt_scheduler_submit().
+ */
+typedef void (*nbt_scheduler_completion_t)(ifx_status_t status, void *context);
+
+/**
+ * \brief Hook invoked once on the I/O thread before the first job is executed.
+ *
+ * \param[in] context Arbitrary context set in nbt_scheduler.thread_hook_context.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, the I/O thread is not started otherwise.
+ */
+typedef ifx_status_t (*nbt_scheduler_thread_hook_t)(void *context);
+
+/**
+ * \brief Hook invoked on the I/O thread before every job is executed.
+ *
+ * \param[in] context Arbitrary context set in nbt_scheduler.job_hook_context.
+ * \param[in] priority Priority the job has been queued with.
+ */
+typedef void (*nbt_scheduler_job_hook_t)(void *context, enum nbt_scheduler_priority priority);
+
+/**
+ * \brief Application handler answering a command APDU received via pass-through mode.
+ *
+ * \param[in] command Command APDU sent by the NFC reader.
+ * \param[out] response Response APDU to be sent back (data allocated with \c malloc(), freed by the caller).
+ * \param[in] context Arbitrary context set in nbt_pass_through.context.
+ * \return ifx_status_t \c IFX_SUCCESS if \c response has been set, any other value in case of error.
+ */
+typedef ifx_status_t (*nbt_pass_through_handler_t)(const ifx_apdu_t *command, ifx_apdu_response_t *response, void *context);
+
+/** \struct nbt_pass_through
+ * \brief Context of nbt_scheduler_pass_through_job().
+ */
+struct nbt_pass_through
+{
+    /**
+     * \brief Handler answering the received command.
+     */
+    nbt_pass_through_handler_t handler;
+
+    /**
+     * \brief Context for nbt_pass_through.handler.
+     */
+    void *context;
+};
+
+/** \struct nbt_scheduler_job
+ * \brief Queued job (internal).
+ */
+struct nbt_scheduler_job
+{
+    /**
+     * \brief Job to be executed.
+     */
+    nbt_scheduler_job_t job;
+
+    /**
+     * \brief Optional completion callback.
+     */
+    nbt_scheduler_completion_t completion;
+
+    /**
+     * \brief Context for job and completion callback.
+     */
+    void *context;
+
+    /**
+     * \brief Next job with the same priority.
+     */
+    struct nbt_scheduler_job *next;
+};
+
+/** \struct nbt_scheduler
+ * \brief Single-owner command scheduler.
+ */
+struct nbt_scheduler
+{
+    /**
+     * \brief NBT command abstraction exclusively used by the I/O thread.
+     */
+    nbt_cmd_t *nbt;
+
+    /**
+     * \brief Optional hook run on the I/O thread before serving jobs (e.g. to adjust scheduling policy).
+     */
+    nbt_scheduler_thread_hook_t thread_hook;
+
+    /**
+     * \brief Context for nbt_scheduler.thread_hook.
+     */
+    void *thread_hook_context;
+
+    /**
+     * \brief Optional hook run on the I/O thread before every job (e.g. to tag the exchanges of a priority).
+     */
+    nbt_scheduler_job_hook_t job_hook;
+
+    /**
+     * \brief Context for nbt_scheduler.job_hook.
+     */
+    void *job_hook_context;
+
+    /**
+     * \brief I/O thread.
+     */
+    pthread_t thread;
+
+    /**
+     * \brief Lock protecting the queues and state flags.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * \brief Signalled whenever a job has been queued or the scheduler is stopped.
+     */
+    pthread_cond_t available;
+
+    /**
+     * \brief Queue heads, one FIFO per priority.
+     */
+    struct nbt_scheduler_job *heads[NBT_PRIORITY_COUNT];
+
+    /**
+     * \brief Queue tails, one FIFO per priority.
+     */
+    struct nbt_scheduler_job *tails[NBT_PRIORITY_COUNT];
+
+    /**
+     * \brief Number of jobs executed per priority (statistics).
+     */
+    uint64_t executed[NBT_PRIORITY_COUNT];
+
+    /**
+     * \brief Result of nbt_scheduler.thread_hook reported back to nbt_scheduler_start().
+     */
+    ifx_status_t start_status;
+
+    /**
+     * \brief \c true as soon as the I/O thread has reported nbt_scheduler.start_status.
+     */
+    bool started;
+
+    /**
+     * \brief \c true while the I/O thread accepts jobs.
+     */
+    bool running;
+};
+
+/**
+ * \brief Initializes scheduler and starts the I/O thread.
+ *
+ * \details nbt_scheduler.thread_hook, nbt_scheduler.job_hook and their contexts may be set before calling this
+ * function, all other members are initialized here.
+ *
+ * \param[in] self Scheduler to be started.
+ * \param[in] nbt NBT command abstraction to be owned by the I/O thread. Must not be used by any other thread afterwards.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_scheduler_start(struct nbt_scheduler *self, nbt_cmd_t *nbt);
+
+/**
+ * \brief Queues job for asynchronous execution on the I/O thread.
+ *
+ * \details Jobs of the same priority are executed in submission order, higher priorities always jump ahead of queued
+ * lower priority jobs. A job currently executing is never interrupted.
+ *
+ * \param[in] self Scheduler.
+ * \param[in] priority Job priority.
+ * \param[in] job Job to be executed.
+ * \param[in] completion Optional completion callback (may be \c NULL).
+ * \param[in] context Context passed to job and completion callback.
+ * \return ifx_status_t \c IFX_SUCCESS if job has been queued, any other value in case of error.
+ */
+ifx_status_t nbt_scheduler_submit(struct nbt_scheduler *self, enum nbt_scheduler_priority priority, nbt_scheduler_job_t job,
+                                  nbt_scheduler_completion_t completion, void *context);
+
+/**
+ * \brief Queues job and blocks until it has been executed.
+ *
+ * \details Must not be called from the I/O thread itself.
+ *
+ * \param[in] self Scheduler.
+ * \param[in] priority Job priority.
+ * \param[in] job Job to be executed.
+ * \param[in] context Context passed to job.
+ * \return ifx_status_t Status returned by the job, any other value in case of error.
+ */
+ifx_status_t nbt_scheduler_execute(struct nbt_scheduler *self, enum nbt_scheduler_priority priority, nbt_scheduler_job_t job, void *context);
+
+/**
+ * \brief Stops I/O thread and frees scheduler resources.
+ *
+ * \details Jobs already queued are still executed before the I/O thread terminates.
+ *
+ * \param[in] self Scheduler to be stopped.
+ */
+void nbt_scheduler_stop(struct nbt_scheduler *self);
+
+/**
+ * \brief Scheduler job fetching a pending pass-through command from the NBT and sending the handler's response.
+ *
+ * \details Meant to be submitted with \c NBT_PRIORITY_PASS_THROUGH as soon as the NBT signals a pass-through command,
+ * so that it jumps ahead of queued bulk writes. If the handler fails, status word \c 6F00 is sent so that the NFC
+ * reader is not left waiting.
+ *
+ * \param[in] nbt NBT command abstraction owned by the scheduler.
+ * \param[in] context Pass-through handler (\c const struct nbt_pass_through *).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_scheduler_pass_through_job(nbt_cmd_t *nbt, void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NBT_SCHEDULER_H
@@ -0,0 +1,510 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-trace.c
+ * \brief Binary trace of the T=1' frames and APDU exchanges with the NBT in a memory mapped ring file.
+ */
+#include <endian.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-logger.h"
+#include "infineon/ifx-protocol.h"
+
+#include "nbt-trace.h"
+
+/**
+ * \brief String used as source information for logging.
+ */
+#define LOG_TAG "NBT trace"
+
+/**
+ * \brief Returns number of bytes a record with the given payload length occupies in the ring.
+ *
+ * \param[in] length Payload length.
+ * \return size_t Record size including header and padding.
+ */
+static size_t nbt_trace_record_size(size_t length)
+{
+    return sizeof(struct nbt_trace_record) + ((length + NBT_TRACE_ALIGNMENT - 1U) & ~((size_t) NBT_TRACE_ALIGNMENT - 1U));
+}
+
+/**
+ * \brief Checks trace header against the size of the mapped file.
+ *
+ * \param[in] header Trace header.
+ * \param[in] length Length of the mapped file.
+ * \return bool \c true if header is valid.
+ */
+static bool nbt_trace_header_valid(const struct nbt_trace_header *header, size_t length)
+{
+    if ((length < sizeof(struct nbt_trace_header)) || (memcmp(header->magic, NBT_TRACE_MAGIC, sizeof(header->magic)) != 0) ||
+        (le16toh(header->version) != NBT_TRACE_VERSION) || (le16toh(header->header_size) != sizeof(struct nbt_trace_header)))
+    {
+        return false;
+    }
+    uint32_t capacity = le32toh(header->capacity);
+    uint64_t head = le64toh(header->head);
+    uint64_t tail = le64toh(header->tail);
+    return (capacity >= NBT_TRACE_MIN_CAPACITY) && ((capacity % NBT_TRACE_ALIGNMENT) == 0U) && (length == (sizeof(struct nbt_trace_header) + capacity)) &&
+           (tail <= head) && ((head - tail) <= capacity) && ((tail % NBT_TRACE_ALIGNMENT) == 0U);
+}
+
+/**
+ * \brief Advances the tail until \c length bytes can be written at \c head.
+ *
+ * \param[in] self Trace.
+ * \param[in] head Absolute offset the next record will be written to.
+ * \param[in] length Number of bytes to be written.
+ */
+static void nbt_trace_reserve(struct nbt_trace *self, uint64_t head, size_t length)
+{
+    uint64_t tail = le64toh(self->header->tail);
+    uint64_t dropped = 0U;
+    while ((head + length - tail) > self->capacity)
+    {
+        const struct nbt_trace_record *oldest = (const struct nbt_trace_record *) (self->ring + (tail % self->capacity));
+        tail += nbt_trace_record_size(le16toh(oldest->length));
+        dropped += (oldest->type != NBT_TRACE_RECORD_PADDING) ? 1U : 0U;
+    }
+    self->header->dropped = htole64(le64toh(self->header->dropped) + dropped);
+    __atomic_store_n(&self->header->tail, htole64(tail), __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief Writes record header and payload into the ring (space must have been reserved).
+ *
+ * \param[in] self Trace.
+ * \param[in] position Absolute offset of the record.
+ * \param[in] type Record type.
+ * \param[in] flags Record flags.
+ * \param[in] timestamp_ns Start of traced operation.
+ * \param[in] duration_ns Duration of traced operation.
+ * \param[in] payload Record payload.
+ * \param[in] length Number of bytes in \c payload.
+ */
+static void nbt_trace_write(struct nbt_trace *self, uint64_t position, enum nbt_trace_record_type type, uint8_t flags, uint64_t timestamp_ns,
+                            uint64_t duration_ns, const uint8_t *payload, size_t length)
+{
+    struct nbt_trace_record record = {.timestamp_ns = htole64(timestamp_ns),
+                                      .duration_ns = htole32((duration_ns > UINT32_MAX) ? UINT32_MAX : (uint32_t) duration_ns),
+                                      .length = htole16((uint16_t) length),
+                                      .type = (uint8_t) type,
+                                      .flags = flags};
+    uint8_t *destination = self->ring + (position % self->capacity);
+    memcpy(destination, &record, sizeof(record));
+    if (length > 0U)
+    {
+        memcpy(destination + sizeof(record), payload, length);
+    }
+}
+
+/**
+ * \brief Returns current \c CLOCK_MONOTONIC time in nanoseconds as used for record timestamps.
+ *
+ * \return uint64_t Current time.
+ */
+uint64_t nbt_trace_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000U) + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * \brief Appends record to the trace, overwriting the oldest records if the ring is full.
+ *
+ * \details Does nothing if the trace is not open for recording, recording is paused (nbt_trace.paused) or the record
+ * does not fit into the ring.
+ *
+ * \param[in] self Trace.
+ * \param[in] type Record type.
+ * \param[in] flags Record flags.
+ * \param[in] timestamp_ns Start of traced operation (nbt_trace_now_ns()).
+ * \param[in] duration_ns Duration of traced operation.
+ * \param[in] payload Record payload (may be \c NULL if \c length is 0).
+ * \param[in] length Number of bytes in \c payload.
+ */
+void nbt_trace_record(struct nbt_trace *self, enum nbt_trace_record_type type, uint8_t flags, uint64_t timestamp_ns, uint64_t duration_ns,
+                      const uint8_t *payload, size_t length)
+{
+    size_t size = nbt_trace_record_size(length);
+    if ((self == NULL) || !self->writable || self->paused || (length > UINT16_MAX) || (size > self->capacity))
+    {
+        return;
+    }
+    uint64_t head = le64toh(self->header->head);
+
+    // Never split a record at the end of the ring, fill the remainder with padding instead
+    size_t remainder = self->capacity - (size_t) (head % self->capacity);
+    if (remainder < size)
+    {
+        nbt_trace_reserve(self, head, remainder);
+        struct nbt_trace_record padding = {.timestamp_ns = htole64(timestamp_ns),
+                                           .length = htole16((uint16_t) (remainder - sizeof(struct nbt_trace_record))),
+                                           .type = NBT_TRACE_RECORD_PADDING};
+        memcpy(self->ring + (head % self->capacity), &padding, sizeof(padding));
+        head += remainder;
+    }
+    nbt_trace_reserve(self, head, size);
+    nbt_trace_write(self, head, type, flags, timestamp_ns, duration_ns, payload, length);
+    self->header->records = htole64(le64toh(self->header->records) + 1U);
+
+    // Publish record only after it has been written completely
+    __atomic_store_n(&self->header->head, htole64(head + size), __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief Opens (or creates) trace file for recording and appends a session record.
+ *
+ * \details An existing trace of the same capacity is continued, anything else is reinitialized. The file is only
+ * accessible by its owner (mode 0600), as traces contain the OOB password and proprietary file contents.
+ *
+ * \param[in] self Trace to be opened.
+ * \param[in] path Trace file.
+ * \param[in] capacity Ring capacity in bytes (0 for \c NBT_TRACE_DEFAULT_CAPACITY).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_trace_open(struct nbt_trace *self, const char *path, uint32_t capacity)
+{
+    if ((self == NULL) || (path == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_OPEN, IFX_ILLEGAL_ARGUMENT);
+    }
+    memset(self, 0, sizeof(struct nbt_trace));
+    capacity = (capacity == 0U) ? NBT_TRACE_DEFAULT_CAPACITY : capacity;
+    capacity = (capacity < NBT_TRACE_MIN_CAPACITY) ? NBT_TRACE_MIN_CAPACITY : capacity;
+    capacity = (capacity + NBT_TRACE_ALIGNMENT - 1U) & ~(NBT_TRACE_ALIGNMENT - 1U);
+    size_t length = sizeof(struct nbt_trace_header) + capacity;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not open trace file %s: %s", path, strerror(errno));
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_OPEN, IFX_UNSPECIFIED_ERROR);
+    }
+    // Restrict existing traces as well (earlier versions created them with mode 0644)
+    struct stat file_stat;
+    if ((fstat(fd, &file_stat) != 0) || (((file_stat.st_mode & (S_IRWXG | S_IRWXO)) != 0U) && (fchmod(fd, S_IRUSR | S_IWUSR) != 0)))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not restrict access to trace file %s: %s", path, strerror(errno));
+        close(fd);
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_OPEN, IFX_UNSPECIFIED_ERROR);
+    }
+    if (((size_t) file_stat.st_size != length) && (ftruncate(fd, (off_t) length) != 0))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not resize trace file %s: %s", path, strerror(errno));
+        close(fd);
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_OPEN, IFX_UNSPECIFIED_ERROR);
+    }
+    void *mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not map trace file %s: %s", path, strerror(errno));
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_OPEN, IFX_UNSPECIFIED_ERROR);
+    }
+    self->mapping = (uint8_t *) mapping;
+    self->length = length;
+    self->header = (struct nbt_trace_header *) mapping;
+    self->ring = self->mapping + sizeof(struct nbt_trace_header);
+    self->capacity = capacity;
+    self->writable = true;
+
+    if (!nbt_trace_header_valid(self->header, length))
+    {
+        memset(self->header, 0, sizeof(struct nbt_trace_header));
+        memcpy(self->header->magic, NBT_TRACE_MAGIC, sizeof(self->header->magic));
+        self->header->version = htole16(NBT_TRACE_VERSION);
+        self->header->header_size = htole16(sizeof(struct nbt_trace_header));
+        self->header->capacity = htole32(capacity);
+        self->header->alignment = htole32(NBT_TRACE_ALIGNMENT);
+    }
+
+    // Mark start of session with wall clock time, so that monotonic timestamps of different sessions can be told apart
+    struct timespec realtime;
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    uint64_t realtime_ns = htole64(((uint64_t) realtime.tv_sec * 1000000000U) + (uint64_t) realtime.tv_nsec);
+    nbt_trace_record(self, NBT_TRACE_RECORD_SESSION, 0U, nbt_trace_now_ns(), 0U, (const uint8_t *) &realtime_ns, sizeof(realtime_ns));
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Maps trace file read-only for analysis and validates its header.
+ *
+ * \param[in] self Trace to be loaded.
+ * \param[in] path Trace file.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_trace_load(struct nbt_trace *self, const char *path)
+{
+    if ((self == NULL) || (path == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_LOAD, IFX_ILLEGAL_ARGUMENT);
+    }
+    memset(self, 0, sizeof(struct nbt_trace));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not open trace file %s: %s", path, strerror(errno));
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_LOAD, IFX_UNSPECIFIED_ERROR);
+    }
+    struct stat file_stat;
+    if ((fstat(fd, &file_stat) != 0) || ((size_t) file_stat.st_size < sizeof(struct nbt_trace_header)))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid trace file %s", path);
+        close(fd);
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_LOAD, NBT_TRACE_INVALID);
+    }
+    void *mapping = mmap(NULL, (size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not map trace file %s: %s", path, strerror(errno));
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_LOAD, IFX_UNSPECIFIED_ERROR);
+    }
+    if (!nbt_trace_header_valid((const struct nbt_trace_header *) mapping, (size_t) file_stat.st_size))
+    {
+        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid trace file %s", path);
+        munmap(mapping, (size_t) file_stat.st_size);
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_LOAD, NBT_TRACE_INVALID);
+    }
+    self->mapping = (uint8_t *) mapping;
+    self->length = (size_t) file_stat.st_size;
+    self->header = (struct nbt_trace_header *) mapping;
+    self->ring = self->mapping + sizeof(struct nbt_trace_header);
+    self->capacity = le32toh(self->header->capacity);
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Unmaps trace opened with nbt_trace_open() or nbt_trace_load().
+ *
+ * \param[in] self Trace (may be zero initialized).
+ */
+void nbt_trace_close(struct nbt_trace *self)
+{
+    if ((self != NULL) && (self->mapping != NULL))
+    {
+        if (self->writable)
+        {
+            msync(self->mapping, self->length, MS_ASYNC);
+        }
+        munmap(self->mapping, self->length);
+        memset(self, 0, sizeof(struct nbt_trace));
+    }
+}
+
+/**
+ * \brief Iterates over all records in the ring from oldest to newest (skipping padding).
+ *
+ * \param[in] self Trace.
+ * \param[in,out] position Absolute offset of the next record (initialize with 0).
+ * \param[out] record Record header (host byte order).
+ * \param[out] payload Record payload within the mapped trace.
+ * \return bool \c true if a record has been returned, \c false at the end of the trace or if it is corrupted.
+ */
+bool nbt_trace_next(const struct nbt_trace *self, uint64_t *position, struct nbt_trace_record *record, const uint8_t **payload)
+{
+    if ((self == NULL) || (self->mapping == NULL) || (position == NULL) || (record == NULL) || (payload == NULL))
+    {
+        return false;
+    }
+    uint64_t head = le64toh(__atomic_load_n(&self->header->head, __ATOMIC_ACQUIRE));
+    uint64_t tail = le64toh(__atomic_load_n(&self->header->tail, __ATOMIC_ACQUIRE));
+    if (*position < tail)
+    {
+        *position = tail;
+    }
+    while (*position < head)
+    {
+        size_t offset = (size_t) (*position % self->capacity);
+        const struct nbt_trace_record *stored = (const struct nbt_trace_record *) (self->ring + offset);
+        record->timestamp_ns = le64toh(stored->timestamp_ns);
+        record->duration_ns = le32toh(stored->duration_ns);
+        record->length = le16toh(stored->length);
+        record->type = stored->type;
+        record->flags = stored->flags;
+        size_t size = nbt_trace_record_size(record->length);
+        if (size > (self->capacity - offset))
+        {
+            return false;
+        }
+        *position += size;
+        if (record->type != NBT_TRACE_RECORD_PADDING)
+        {
+            *payload = self->ring + offset + sizeof(struct nbt_trace_record);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * \brief Transmits frame via the wrapped driver adapter and records it.
+ *
+ * \param[in] self Frame tap.
+ * \param[in] data Frame to be sent.
+ * \param[in] data_len Number of bytes in \c data.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_trace_tap_transmit(ifx_protocol_t *self, const uint8_t *data, size_t data_len)
+{
+    struct nbt_trace_tap *tap = (struct nbt_trace_tap *) self;
+    uint64_t start = nbt_trace_now_ns();
+    ifx_status_t status = ifx_protocol_transmit(tap->driver, data, data_len);
+    nbt_trace_record(tap->trace, NBT_TRACE_RECORD_FRAME_TX, ifx_error_check(status) ? NBT_TRACE_FLAG_ERROR : 0U, start, nbt_trace_now_ns() - start,
+                     data, data_len);
+    return status;
+}
+
+/**
+ * \brief Receives frame via the wrapped driver adapter and records it.
+ *
+ * \param[in] self Frame tap.
+ * \param[in] expected_len Number of bytes expected.
+ * \param[out] response Buffer to store response in.
+ * \param[out] response_len Buffer to store number of received bytes in.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_trace_tap_receive(ifx_protocol_t *self, size_t expected_len, uint8_t **response, size_t *response_len)
+{
+    struct nbt_trace_tap *tap = (struct nbt_trace_tap *) self;
+    uint64_t start = nbt_trace_now_ns();
+    ifx_status_t status = ifx_protocol_receive(tap->driver, expected_len, response, response_len);
+    uint64_t duration = nbt_trace_now_ns() - start;
+    if (ifx_error_check(status))
+    {
+        nbt_trace_record(tap->trace, NBT_TRACE_RECORD_FRAME_RX, NBT_TRACE_FLAG_ERROR, start, duration, NULL, 0U);
+    }
+    else
+    {
+        nbt_trace_record(tap->trace, NBT_TRACE_RECORD_FRAME_RX, 0U, start, duration, *response, *response_len);
+    }
+    return status;
+}
+
+/**
+ * \brief Initializes frame tap around an already initialized I2C driver adapter.
+ *
+ * \param[in] self Tap to be initialized (use nbt_trace_tap.protocol as base of the T=1' layer).
+ * \param[in] driver I2C driver adapter.
+ * \param[in] trace Trace opened for recording.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_trace_tap_initialize(struct nbt_trace_tap *self, ifx_protocol_t *driver, struct nbt_trace *trace)
+{
+    if ((self == NULL) || (driver == NULL) || (driver->_transmit == NULL) || (driver->_receive == NULL) || (trace == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_INITIALIZE, IFX_ILLEGAL_ARGUMENT);
+    }
+    self->protocol = *driver;
+    self->protocol._transmit = nbt_trace_tap_transmit;
+    self->protocol._receive = nbt_trace_tap_receive;
+    self->driver = driver;
+    self->trace = trace;
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Activates underlying protocol and records activation response.
+ *
+ * \param[in] self APDU trace protocol layer.
+ * \param[out] response Buffer to store activation response in.
+ * \param[out] response_len Buffer to store number of received bytes in.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_trace_activate(ifx_protocol_t *self, uint8_t **response, size_t *response_len)
+{
+    struct nbt_trace *trace = (struct nbt_trace *) self->_properties;
+    uint64_t start = nbt_trace_now_ns();
+    ifx_status_t status = ifx_protocol_activate(self->_base, response, response_len);
+    uint64_t duration = nbt_trace_now_ns() - start;
+    if (ifx_error_check(status) || (response == NULL) || (response_len == NULL))
+    {
+        nbt_trace_record(trace, NBT_TRACE_RECORD_ACTIVATE, ifx_error_check(status) ? NBT_TRACE_FLAG_ERROR : 0U, start, duration, NULL, 0U);
+    }
+    else
+    {
+        nbt_trace_record(trace, NBT_TRACE_RECORD_ACTIVATE, 0U, start, duration, *response, *response_len);
+    }
+    return status;
+}
+
+/**
+ * \brief Exchanges one APDU via the underlying protocol and records command and response.
+ *
+ * \param[in] self APDU trace protocol layer.
+ * \param[in] data Data to be sent.
+ * \param[in] data_len Number of bytes in \c data.
+ * \param[out] response Buffer to store response in.
+ * \param[out] response_len Buffer to store number of received bytes in.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+static ifx_status_t nbt_trace_transceive(ifx_protocol_t *self, const uint8_t *data, size_t data_len, uint8_t **response, size_t *response_len)
+{
+    struct nbt_trace *trace = (struct nbt_trace *) self->_properties;
+    uint64_t start = nbt_trace_now_ns();
+    nbt_trace_record(trace, NBT_TRACE_RECORD_APDU, 0U, start, 0U, data, data_len);
+    ifx_status_t status = ifx_protocol_transceive(self->_base, data, data_len, response, response_len);
+    uint64_t duration = nbt_trace_now_ns() - start;
+    if (ifx_error_check(status))
+    {
+        nbt_trace_record(trace, NBT_TRACE_RECORD_RESPONSE, NBT_TRACE_FLAG_ERROR, start, duration, NULL, 0U);
+    }
+    else
+    {
+        nbt_trace_record(trace, NBT_TRACE_RECORD_RESPONSE, 0U, start, duration, *response, *response_len);
+    }
+    return status;
+}
+
+/**
+ * \brief Detaches layer from trace (the trace itself is owned by the caller).
+ *
+ * \param[in] self APDU trace protocol layer.
+ */
+static void nbt_trace_destroy(ifx_protocol_t *self)
+{
+    self->_properties = NULL;
+}
+
+/**
+ * \brief Initializes APDU trace protocol layer on top of an already initialized protocol stack.
+ *
+ * \details Destroying this layer with ifx_protocol_destroy() also destroys the underlying stack, but not the trace.
+ *
+ * \param[in] self Protocol object to be initialized.
+ * \param[in] base Underlying protocol (e.g. GP T=1').
+ * \param[in] trace Trace opened for recording.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_trace_initialize(ifx_protocol_t *self, ifx_protocol_t *base, struct nbt_trace *trace)
+{
+    if ((self == NULL) || (base == NULL) || (trace == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_TRACE, NBT_TRACE_INITIALIZE, IFX_ILLEGAL_ARGUMENT);
+    }
+    ifx_status_t status = ifx_protocol_layer_initialize(self);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
+    self->_layer_id = NBT_TRACE_PROTOCOL_LAYER_ID;
+    self->_base = base;
+    self->_activate = nbt_trace_activate;
+    self->_transceive = nbt_trace_transceive;
+    self->_destructor = nbt_trace_destroy;
+    self->_properties = trace;
+    return IFX_SUCCESS;
+}
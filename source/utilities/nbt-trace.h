@@ -0,0 +1,387 @@
+// SPDX-FileCopyrightText: Copyright (c) 2025 Infineon Technologies AG
+// SPDX-License-Identifier: MIT
+
+/**
+ * \file nbt-trace.h
+ * \brief Binary trace of the T=1' frames and APDU exchanges with the NBT in a memory mapped ring file.
+ *
+ * \details Two taps feed the same trace:
+ *
+ *   * nbt_trace_tap_initialize() wraps the I2C driver adapter and records every transmitted and received T=1' frame
+ *     (a single frame may be received in several transfers).
+ *   * nbt_trace_initialize() is a protocol layer stacked on top of the GP T=1' protocol and records every APDU, its
+ *     response and the time the exchange took.
+ *
+ * The trace file is a fixed size ring: a header followed by \c capacity bytes of records. Records are never split at
+ * the end of the ring (the remainder is filled with a padding record) and the oldest records are overwritten once the
+ * ring is full. All integers are little endian:
+ *
+ *   | Offset           | Size     | Content                                                        |
+ *   | ---------------- | -------- | -------------------------------------------------------------- |
+ *   | 0                | 64       | struct nbt_trace_header                                        |
+ *   | 64 + position    | 16       | struct nbt_trace_record (position = absolute offset % capacity) |
+ *   | 64 + position+16 | length   | Record payload, padded to \c NBT_TRACE_ALIGNMENT               |
+ *
+ * The file is shared memory mapped, so records survive a crash of the recording process. Recording is not thread safe
+ * and must only happen from the thread owning the protocol stack (the scheduler's I/O thread).
+ */
+#ifndef NBT_TRACE_H
+#define NBT_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infineon/ifx-error.h"
+#include "infineon/ifx-protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Identifier for the trace module used in error codes.
+ */
+#define LIB_NBT_TRACE 0x68U
+
+/**
+ * \brief IFX protocol layer ID of the APDU trace layer.
+ */
+#define NBT_TRACE_PROTOCOL_LAYER_ID 0x68U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_trace_open().
+ */
+#define NBT_TRACE_OPEN 0x01U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_trace_load().
+ */
+#define NBT_TRACE_LOAD 0x02U
+
+/**
+ * \brief IFX error encoding function identifier for nbt_trace_initialize() and nbt_trace_tap_initialize().
+ */
+#define NBT_TRACE_INITIALIZE 0x03U
+
+/**
+ * \brief Error reason if a trace file is malformed or of an unsupported version.
+ */
+#define NBT_TRACE_INVALID 0x20U
+
+/**
+ * \brief Magic bytes at the start of every trace file.
+ */
+#define NBT_TRACE_MAGIC "NBTR"
+
+/**
+ * \brief Current trace format version.
+ */
+#define NBT_TRACE_VERSION 1U
+
+/**
+ * \brief Alignment of records within the ring.
+ */
+#define NBT_TRACE_ALIGNMENT 16U
+
+/**
+ * \brief Default ring capacity in bytes.
+ */
+#define NBT_TRACE_DEFAULT_CAPACITY (1024U * 1024U)
+
+/**
+ * \brief Minimum ring capacity in bytes.
+ */
+#define NBT_TRACE_MIN_CAPACITY (16U * 1024U)
+
+/**
+ * \brief Record flag set if the traced operation failed.
+ */
+#define NBT_TRACE_FLAG_ERROR 0x01U
+
+/**
+ * \brief Record types.
+ */
+enum nbt_trace_record_type
+{
+    /**
+     * \brief Unused space up to the end of the ring.
+     */
+    NBT_TRACE_RECORD_PADDING = 0x00U,
+
+    /**
+     * \brief Start of a recording session (payload: wall clock time in nanoseconds since the epoch as \c uint64_t).
+     */
+    NBT_TRACE_RECORD_SESSION = 0x01U,
+
+    /**
+     * \brief T=1' frame transmitted by the driver adapter.
+     */
+    NBT_TRACE_RECORD_FRAME_TX = 0x02U,
+
+    /**
+     * \brief T=1' frame (or part of it) received by the driver adapter.
+     */
+    NBT_TRACE_RECORD_FRAME_RX = 0x03U,
+
+    /**
+     * \brief Protocol activation (payload: activation response, if requested by the caller).
+     */
+    NBT_TRACE_RECORD_ACTIVATE = 0x04U,
+
+    /**
+     * \brief Command APDU (recorded before it is sent).
+     */
+    NBT_TRACE_RECORD_APDU = 0x05U,
+
+    /**
+     * \brief Response APDU including status word (timestamp and duration cover the complete exchange).
+     */
+    NBT_TRACE_RECORD_RESPONSE = 0x06U
+};
+
+/** \struct nbt_trace_header
+ * \brief Trace file header as stored at offset 0.
+ */
+struct nbt_trace_header
+{
+    /**
+     * \brief Magic bytes \c NBT_TRACE_MAGIC.
+     */
+    uint8_t magic[4];
+
+    /**
+     * \brief Trace format version (\c NBT_TRACE_VERSION).
+     */
+    uint16_t version;
+
+    /**
+     * \brief Size of this header (offset of the ring).
+     */
+    uint16_t header_size;
+
+    /**
+     * \brief Ring capacity in bytes (multiple of \c NBT_TRACE_ALIGNMENT).
+     */
+    uint32_t capacity;
+
+    /**
+     * \brief Record alignment (\c NBT_TRACE_ALIGNMENT).
+     */
+    uint32_t alignment;
+
+    /**
+     * \brief Absolute offset of the next record to be written.
+     */
+    uint64_t head;
+
+    /**
+     * \brief Absolute offset of the oldest record still in the ring.
+     */
+    uint64_t tail;
+
+    /**
+     * \brief Number of records ever written.
+     */
+    uint64_t records;
+
+    /**
+     * \brief Number of records overwritten because the ring was full.
+     */
+    uint64_t dropped;
+
+    /**
+     * \brief Reserved (0x00).
+     */
+    uint8_t reserved[16];
+};
+
+/** \struct nbt_trace_record
+ * \brief Record header preceding every payload in the ring.
+ */
+struct nbt_trace_record
+{
+    /**
+     * \brief \c CLOCK_MONOTONIC time the traced operation started in nanoseconds.
+     */
+    uint64_t timestamp_ns;
+
+    /**
+     * \brief Duration of the traced operation in nanoseconds (saturated).
+     */
+    uint32_t duration_ns;
+
+    /**
+     * \brief Payload length in bytes.
+     */
+    uint16_t length;
+
+    /**
+     * \brief Record type (\c enum nbt_trace_record_type).
+     */
+    uint8_t type;
+
+    /**
+     * \brief Record flags (\c NBT_TRACE_FLAG_*).
+     */
+    uint8_t flags;
+};
+
+/** \struct nbt_trace
+ * \brief Memory mapped trace file.
+ */
+struct nbt_trace
+{
+    /**
+     * \brief Mapped trace file.
+     */
+    uint8_t *mapping;
+
+    /**
+     * \brief Length of nbt_trace.mapping in bytes.
+     */
+    size_t length;
+
+    /**
+     * \brief Trace file header within nbt_trace.mapping.
+     */
+    struct nbt_trace_header *header;
+
+    /**
+     * \brief Ring within nbt_trace.mapping.
+     */
+    uint8_t *ring;
+
+    /**
+     * \brief Ring capacity in bytes (host byte order).
+     */
+    uint32_t capacity;
+
+    /**
+     * \brief \c true if opened for recording with nbt_trace_open().
+     */
+    bool writable;
+
+    /**
+     * \brief Set to skip all records (e.g. of periodic health probes) until cleared again. Must only be changed from the
+     * thread recording into the trace.
+     */
+    bool paused;
+};
+
+/** \struct nbt_trace_tap
+ * \brief Copy of an I2C driver adapter recording all frames passing through it.
+ *
+ * \details The tap keeps layer ID and properties of the wrapped driver, so driver specific functions called by the
+ * T=1' layer on its base keep working. Destroying the tap (recursively via ifx_protocol_destroy() of the stack on top
+ * of it) destroys the wrapped driver adapter.
+ */
+struct nbt_trace_tap
+{
+    /**
+     * \brief Protocol to be used as base of the T=1' layer (must stay first member).
+     */
+    ifx_protocol_t protocol;
+
+    /**
+     * \brief Wrapped driver adapter.
+     */
+    ifx_protocol_t *driver;
+
+    /**
+     * \brief Trace to record frames in.
+     */
+    struct nbt_trace *trace;
+};
+
+/**
+ * \brief Opens (or creates) trace file for recording and appends a session record.
+ *
+ * \details An existing trace of the same capacity is continued, anything else is reinitialized. The file is only
+ * accessible by its owner (mode 0600), as traces contain the OOB password and proprietary file contents.
+ *
+ * \param[in] self Trace to be opened.
+ * \param[in] path Trace file.
+ * \param[in] capacity Ring capacity in bytes (0 for \c NBT_TRACE_DEFAULT_CAPACITY).
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_trace_open(struct nbt_trace *self, const char *path, uint32_t capacity);
+
+/**
+ * \brief Maps trace file read-only for analysis and validates its header.
+ *
+ * \param[in] self Trace to be loaded.
+ * \param[in] path Trace file.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_trace_load(struct nbt_trace *self, const char *path);
+
+/**
+ * \brief Unmaps trace opened with nbt_trace_open() or nbt_trace_load().
+ *
+ * \param[in] self Trace (may be zero initialized).
+ */
+void nbt_trace_close(struct nbt_trace *self);
+
+/**
+ * \brief Returns current \c CLOCK_MONOTONIC time in nanoseconds as used for record timestamps.
+ *
+ * \return uint64_t Current time.
+ */
+uint64_t nbt_trace_now_ns(void);
+
+/**
+ * \brief Appends record to the trace, overwriting the oldest records if the ring is full.
+ *
+ * \details Does nothing if the trace is not open for recording, recording is paused (nbt_trace.paused) or the record
+ * does not fit into the ring.
+ *
+ * \param[in] self Trace.
+ * \param[in] type Record type.
+ * \param[in] flags Record flags.
+ * \param[in] timestamp_ns Start of traced operation (nbt_trace_now_ns()).
+ * \param[in] duration_ns Duration of traced operation.
+ * \param[in] payload Record payload (may be \c NULL if \c length is 0).
+ * \param[in] length Number of bytes in \c payload.
+ */
+void nbt_trace_record(struct nbt_trace *self, enum nbt_trace_record_type type, uint8_t flags, uint64_t timestamp_ns, uint64_t duration_ns,
+                      const uint8_t *payload, size_t length);
+
+/**
+ * \brief Iterates over all records in the ring from oldest to newest (skipping padding).
+ *
+ * \param[in] self Trace.
+ * \param[in,out] position Absolute offset of the next record (initialize with 0).
+ * \param[out] record Record header (host byte order).
+ * \param[out] payload Record payload within the mapped trace.
+ * \return bool \c true if a record has been returned, \c false at the end of the trace or if it is corrupted.
+ */
+bool nbt_trace_next(const struct nbt_trace *self, uint64_t *position, struct nbt_trace_record *record, const uint8_t **payload);
+
+/**
+ * \brief Initializes frame tap around an already initialized I2C driver adapter.
+ *
+ * \param[in] self Tap to be initialized (use nbt_trace_tap.protocol as base of the T=1' layer).
+ * \param[in] driver I2C driver adapter.
+ * \param[in] trace Trace opened for recording.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_trace_tap_initialize(struct nbt_trace_tap *self, ifx_protocol_t *driver, struct nbt_trace *trace);
+
+/**
+ * \brief Initializes APDU trace protocol layer on top of an already initialized protocol stack.
+ *
+ * \details Destroying this layer with ifx_protocol_destroy() also destroys the underlying stack, but not the trace.
+ *
+ * \param[in] self Protocol object to be initialized.
+ * \param[in] base Underlying protocol (e.g. GP T=1').
+ * \param[in] trace Trace opened for recording.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_trace_initialize(ifx_protocol_t *self, ifx_protocol_t *base, struct nbt_trace *trace);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NBT_TRACE_H
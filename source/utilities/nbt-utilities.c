@@ -60,21 +60,24 @@ ifx_status_t nbt_select_nbt_application(nbt_cmd_t *nbt)
 }
 
 /**
- * \brief Configures NBT according to given configuration.
+ * \brief Updates file access policies that differ from the ones currently set.
+ *
+ * \details Leaves the NBT application selected.
  *
  * \param[in] nbt NBT abstraction for communication.
- * \param[in] configuration Desired NBT configuration to be set.
+ * \param[in] fap File access policies to be set.
+ * \param[in] fap_len Number of file access policies in \c fap.
  * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
  */
-ifx_status_t nbt_configure(nbt_cmd_t *nbt, const struct nbt_configuration *configuration)
+ifx_status_t nbt_update_file_access_policies(nbt_cmd_t *nbt, nbt_file_access_policy_t *const *fap, size_t fap_len)
 {
     // Validate parameters
-    if ((nbt == NULL) || (configuration == NULL))
+    if ((nbt == NULL) || ((fap == NULL) && (fap_len > 0U)))
     {
-        return IFX_ERROR(LIB_NBT_APDU, NBT_SET_CONFIGURATION, IFX_ILLEGAL_ARGUMENT);
+        return IFX_ERROR(LIB_NBT_APDU, NBT_UPDATE_FAP_BYTES_WITH_PASSWORD, IFX_ILLEGAL_ARGUMENT);
     }
 
-    // Update file access policies
+    // Select NBT application
     ifx_status_t status = nbt_select_nbt_application(nbt);
     if (ifx_error_check(status))
     {
@@ -100,24 +103,24 @@ ifx_status_t nbt_configure(nbt_cmd_t *nbt, const struct nbt_configuration *confi
     ifx_apdu_response_destroy(nbt->response);
 
     // Check file access policies to be updated
-    for (size_t i = 0U; i < configuration->fap_len; i++)
+    for (size_t i = 0U; i < fap_len; i++)
     {
         bool fap_found = false;
         for (size_t j = 0U; j < (sizeof(current_faps) / sizeof(nbt_file_access_policy_t)); j++)
         {
-            if (configuration->fap[i]->file_id == current_faps[j].file_id)
+            if (fap[i]->file_id == current_faps[j].file_id)
             {
                 fap_found = true;
 
                 // Check if file access policy needs to be updated
-                if (memcmp(configuration->fap[i], &current_faps[j], sizeof(nbt_file_access_policy_t)) != 0)
+                if (memcmp(fap[i], &current_faps[j], sizeof(nbt_file_access_policy_t)) != 0)
                 {
-                    status = nbt_update_fap(nbt, configuration->fap[i]);
+                    status = nbt_update_fap(nbt, fap[i]);
                     ifx_apdu_destroy(nbt->apdu);
                     if (ifx_error_check(status))
                     {
                         // clang-format off
-                        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not update file access policy for file 0x%04X", configuration->fap[i]->file_id);
+                        ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not update file access policy for file 0x%04X", fap[i]->file_id);
                         // clang-format on
                         return status;
                     }
@@ -136,10 +139,34 @@ ifx_status_t nbt_configure(nbt_cmd_t *nbt, const struct nbt_configuration *confi
         }
         if (!fap_found)
         {
-            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "No file access policy found for file ID 0x%04X", configuration->fap[i]);
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "No file access policy found for file ID 0x%04X", fap[i]->file_id);
             return IFX_ERROR(LIB_NBT_APDU, NBT_UPDATE_FAP_BYTES_WITH_PASSWORD, IFX_PROGRAMMING_ERROR);
         }
     }
+    return IFX_SUCCESS;
+}
+
+/**
+ * \brief Configures NBT according to given configuration.
+ *
+ * \param[in] nbt NBT abstraction for communication.
+ * \param[in] configuration Desired NBT configuration to be set.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_configure(nbt_cmd_t *nbt, const struct nbt_configuration *configuration)
+{
+    // Validate parameters
+    if ((nbt == NULL) || (configuration == NULL))
+    {
+        return IFX_ERROR(LIB_NBT_APDU, NBT_SET_CONFIGURATION, IFX_ILLEGAL_ARGUMENT);
+    }
+
+    // Update file access policies
+    ifx_status_t status = nbt_update_file_access_policies(nbt, configuration->fap, configuration->fap_len);
+    if (ifx_error_check(status))
+    {
+        return status;
+    }
 
     // Set interface configuration
     status = nbt_select_configurator_application(nbt);
@@ -229,7 +256,7 @@ ifx_status_t nbt_read_file(nbt_cmd_t *nbt, enum nbt_fileid file_id, uint16_t off
     // Actually read file in chunks
     for (size_t chunk_offset = 0U; chunk_offset < length; chunk_offset += 0xFFU)
     {
-        uint8_t chunk_len = ((length - (offset + chunk_offset)) < 0xFFU) ? (length - (offset + chunk_offset)) : 0xFFU;
+        uint8_t chunk_len = ((length - chunk_offset) < 0xFFU) ? (length - chunk_offset) : 0xFFU;
         status = nbt_read_binary(nbt, offset + chunk_offset, chunk_len);
         ifx_apdu_destroy(nbt->apdu);
         if (ifx_error_check(status))
@@ -296,7 +323,7 @@ ifx_status_t nbt_write_file(nbt_cmd_t *nbt, enum nbt_fileid file_id, uint16_t of
     // Actually write file in chunks
     for (size_t chunk_offset = 0U; chunk_offset < length; chunk_offset += 0xFFU)
     {
-        uint8_t chunk_len = ((length - (offset + chunk_offset)) < 0xFFU) ? (length - (offset + chunk_offset)) : 0xFFU;
+        uint8_t chunk_len = ((length - chunk_offset) < 0xFFU) ? (length - chunk_offset) : 0xFFU;
         status = nbt_update_binary(nbt, offset + chunk_offset, chunk_len, (uint8_t *) (data + chunk_offset));
         ifx_apdu_destroy(nbt->apdu);
         if (ifx_error_check(status))
@@ -315,6 +342,108 @@ ifx_status_t nbt_write_file(nbt_cmd_t *nbt, enum nbt_fileid file_id, uint16_t of
     return IFX_SUCCESS;
 }
 
+/**
+ * \brief Writes only those parts of an NBT file that differ from its known current contents.
+ *
+ * \details Compares \c data against \c current and updates differing ranges with a single nbt_select_file_by_id() and
+ * one nbt_update_binary() per range. Ranges separated by at most \c NBT_WRITE_DIFFERENCES_MERGE_GAP unchanged bytes are
+ * merged, as resending a few bytes is cheaper than an additional command. Nothing is sent if the contents are equal.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] file_id NBT file to be written.
+ * \param[in] offset Offset within NBT file.
+ * \param[in] current Known current file contents at \c offset.
+ * \param[in] data Data to be written.
+ * \param[in] length Number of bytes in \c current and \c data.
+ * \param[out] written Optional, number of bytes actually sent to the NBT.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ * \see nbt_write_file()
+ */
+ifx_status_t nbt_write_file_differences(nbt_cmd_t *nbt, enum nbt_fileid file_id, uint16_t offset, const uint8_t *current, const uint8_t *data,
+                                        size_t length, size_t *written)
+{
+    // Validate parameters
+    if ((nbt == NULL) || (current == NULL) || (data == NULL) || ((offset + length) > 4096U))
+    {
+        return IFX_ERROR(LIB_NBT_APDU, NBT_UPDATE_BINARY, IFX_ILLEGAL_ARGUMENT);
+    }
+    if (written != NULL)
+    {
+        *written = 0U;
+    }
+
+    bool selected = false;
+    size_t position = 0U;
+    while (position < length)
+    {
+        // Find next differing range, merging ranges separated by small gaps
+        while ((position < length) && (current[position] == data[position]))
+        {
+            position++;
+        }
+        if (position == length)
+        {
+            break;
+        }
+        size_t range_start = position;
+        size_t range_end = position;
+        while ((position < length) && ((position - range_start) < 0xFFU))
+        {
+            if (current[position] != data[position])
+            {
+                range_end = position + 1U;
+            }
+            else if ((position - range_end) >= NBT_WRITE_DIFFERENCES_MERGE_GAP)
+            {
+                break;
+            }
+            position++;
+        }
+        position = range_end;
+
+        // Select file lazily so that unchanged contents do not cause any communication
+        if (!selected)
+        {
+            ifx_status_t status = nbt_select_file(nbt, file_id);
+            ifx_apdu_destroy(nbt->apdu);
+            if (ifx_error_check(status))
+            {
+                ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not select NBT file 0x%04X", file_id);
+                return status;
+            }
+            if (nbt->response->sw != 0x9000U)
+            {
+                ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid status word for selecting NBT file 0x%04X: 0x%04X", file_id, nbt->response->sw);
+                ifx_apdu_response_destroy(nbt->response);
+                return IFX_ERROR(LIB_NBT_APDU, NBT_UPDATE_BINARY, IFX_SW_ERROR);
+            }
+            ifx_apdu_response_destroy(nbt->response);
+            selected = true;
+        }
+
+        uint8_t range_len = (uint8_t) (range_end - range_start);
+        ifx_status_t status = nbt_update_binary(nbt, offset + range_start, range_len, (uint8_t *) (data + range_start));
+        ifx_apdu_destroy(nbt->apdu);
+        if (ifx_error_check(status))
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Could not write NBT file 0x%04X", file_id);
+            return status;
+        }
+        if (nbt->response->sw != 0x9000U)
+        {
+            ifx_logger_log(ifx_logger_default, LOG_TAG, IFX_LOG_ERROR, "Invalid status word for writing NBT file 0x%04X: 0x%04X", file_id, nbt->response->sw);
+            ifx_apdu_response_destroy(nbt->response);
+            return IFX_ERROR(LIB_NBT_APDU, NBT_UPDATE_BINARY, IFX_SW_ERROR);
+        }
+        ifx_apdu_response_destroy(nbt->response);
+        if (written != NULL)
+        {
+            *written += range_len;
+        }
+    }
+    return IFX_SUCCESS;
+}
+
 /**
  * \brief Retrieves available APDU received via pass-through mode.
  *
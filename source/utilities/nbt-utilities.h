@@ -24,6 +24,18 @@ extern "C" {
  */
 #define NBT_DEFAULT_I2C_ADDRESS 0x18U
 
+/**
+ * \brief Size of a NBT proprietary file in bytes.
+ */
+#define NBT_PROPRIETARY_FILE_SIZE 1024U
+
+/**
+ * \brief Maximum number of unchanged bytes between two differing ranges that are still written together.
+ *
+ * \see nbt_write_file_differences()
+ */
+#define NBT_WRITE_DIFFERENCES_MERGE_GAP 8U
+
 /** \struct nbt_configuration
  * \brief Simple configuration struct to set NBT to desired state.
  *
@@ -104,6 +116,18 @@ enum nbt_fileid
  */
 ifx_status_t nbt_select_nbt_application(nbt_cmd_t *nbt);
 
+/**
+ * \brief Updates file access policies that differ from the ones currently set.
+ *
+ * \details Leaves the NBT application selected.
+ *
+ * \param[in] nbt NBT abstraction for communication.
+ * \param[in] fap File access policies to be set.
+ * \param[in] fap_len Number of file access policies in \c fap.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ */
+ifx_status_t nbt_update_file_access_policies(nbt_cmd_t *nbt, nbt_file_access_policy_t *const *fap, size_t fap_len);
+
 /**
  * \brief Configures NBT according to given configuration.
  *
@@ -145,6 +169,26 @@ ifx_status_t nbt_read_file(nbt_cmd_t *nbt, enum nbt_fileid file_id, uint16_t off
  */
 ifx_status_t nbt_write_file(nbt_cmd_t *nbt, enum nbt_fileid file_id, uint16_t offset, const uint8_t *data, size_t length);
 
+/**
+ * \brief Writes only those parts of an NBT file that differ from its known current contents.
+ *
+ * \details Compares \c data against \c current and updates differing ranges with a single nbt_select_file_by_id() and
+ * one nbt_update_binary() per range. Ranges separated by at most \c NBT_WRITE_DIFFERENCES_MERGE_GAP unchanged bytes are
+ * merged, as resending a few bytes is cheaper than an additional command. Nothing is sent if the contents are equal.
+ *
+ * \param[in] nbt NBT command abstraction.
+ * \param[in] file_id NBT file to be written.
+ * \param[in] offset Offset within NBT file.
+ * \param[in] current Known current file contents at \c offset.
+ * \param[in] data Data to be written.
+ * \param[in] length Number of bytes in \c current and \c data.
+ * \param[out] written Optional, number of bytes actually sent to the NBT.
+ * \return ifx_status_t \c IFX_SUCCESS if successful, any other value in case of error.
+ * \see nbt_write_file()
+ */
+ifx_status_t nbt_write_file_differences(nbt_cmd_t *nbt, enum nbt_fileid file_id, uint16_t offset, const uint8_t *current, const uint8_t *data,
+                                        size_t length, size_t *written);
+
 /**
  * \brief Retrieves available APDU received via pass-through mode.
  *